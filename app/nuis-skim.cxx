@@ -0,0 +1,97 @@
+#include "nuis/eventinput/EventSourceFactory.h"
+#include "nuis/eventinput/Skim.h"
+
+#include "nuis/record/RecordFactory.h"
+
+#include "nuis/log.txx"
+
+#include "fmt/ranges.h"
+
+#include <iostream>
+
+std::vector<std::string> files_to_read;
+std::string file_to_write;
+std::string plugin_name;
+std::string analysis_cfg;
+
+void SayUsage(char const *argv[]) {
+  std::cout << "[USAGE]: " << argv[0] << "\n"
+            << "\t-i <input1> [input2 ...]  : event files to read\n"
+            << "\t-o <skim.hepmc3>             : hepmc3 file to write\n"
+            << "\t-a <analysis.yaml>           : RecordFactory configuration "
+               "of the analysis whose selection is applied\n"
+            << "\t-p <pluginname>              : The name of the reader plugin "
+               "to use\n"
+            << std::endl;
+}
+
+void handleOpts(int argc, char const *argv[]) {
+  int opt = 1;
+  while (opt < argc) {
+    if (std::string(argv[opt]) == "-?" || std::string(argv[opt]) == "--help") {
+      SayUsage(argv);
+      exit(0);
+    } else if ((opt + 1) < argc) {
+      if (std::string(argv[opt]) == "-i") {
+        while (((opt + 1) < argc) && (argv[opt + 1][0] != '-')) {
+          files_to_read.push_back(argv[++opt]);
+          std::cout << "[INFO]: Reading from " << files_to_read.back()
+                    << std::endl;
+        }
+      } else if (std::string(argv[opt]) == "-o") {
+        file_to_write = argv[++opt];
+      } else if (std::string(argv[opt]) == "-a") {
+        analysis_cfg = argv[++opt];
+      } else if (std::string(argv[opt]) == "-p") {
+        plugin_name = argv[++opt];
+        std::cout << "[INFO]: Reading with plugin " << plugin_name << std::endl;
+      } else {
+        std::cout << "[ERROR]: Unknown option: " << argv[opt] << std::endl;
+        SayUsage(argv);
+        exit(1);
+      }
+    } else {
+      std::cout << "[ERROR]: Unknown option: " << argv[opt] << std::endl;
+      SayUsage(argv);
+      exit(1);
+    }
+    opt++;
+  }
+}
+
+int main(int argc, char const *argv[]) {
+
+  handleOpts(argc, argv);
+
+  if (!files_to_read.size() || !file_to_write.length() ||
+      !analysis_cfg.length()) {
+    nuis::log_critical("[ERROR]: Expected -i, -o, and -a arguments.");
+    return 1;
+  }
+
+  nuis::RecordFactory rfact;
+  auto ana = rfact.make_analysis(YAML::LoadFile(analysis_cfg));
+  if (!ana) {
+    nuis::log_critical("Failed to build analysis from {}", analysis_cfg);
+    return 1;
+  }
+
+  YAML::Node cfg;
+  if (plugin_name.size()) {
+    cfg["plugin_name"] = plugin_name;
+  }
+  cfg["filepaths"] = files_to_read;
+
+  nuis::EventSourceFactory fact;
+  auto [gri, evs] = fact.make(cfg);
+
+  if (!evs) {
+    nuis::log_critical("Failed to find EventSource for input files {}",
+                       files_to_read);
+    return 1;
+  }
+
+  auto summary = nuis::Skim(evs, ana->get_selection().op, file_to_write);
+  nuis::log_info("Wrote {} selected events to {}", summary.nselected,
+                 file_to_write);
+}
@@ -2,25 +2,68 @@
 
 #include "nuis/eventinput/EventSourceFactory.h"
 
+#include "nuis/except.h"
 #include "nuis/log.txx"
 
 #include "fmt/ranges.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+
+DECLARE_NUISANCE_EXCEPT(ShortEventBlock);
 
 std::vector<std::string> files_to_read;
 std::string file_to_write;
 std::string plugin_name;
+size_t nthreads = 1;
+size_t entry_begin = 0;
+size_t entry_end = std::numeric_limits<size_t>::max();
+
+// events are decoded and written in blocks of this many entries
+constexpr size_t const block_size = 1000;
+constexpr size_t const report_every = 100000;
 
 void SayUsage(char const *argv[]) {
   std::cout << "[USAGE]: " << argv[0] << "\n"
-            << "\t-i <input1> [input2 ...]  : neutvect file to read\n"
-            << "\t-o <neut.hepmc3>             : hepmc3 file to write\n"
+            << "\t-i <input1> [input2 ...]     : event files to read, in any "
+               "format with an EventInput plugin, or HepMC3\n"
+            << "\t-o <output.hepmc3>           : hepmc3 file to write\n"
             << "\t-p <pluginname>              : The name of the reader plugin "
                "to use\n"
+            << "\t-j <N>                       : Decode input events on N "
+               "threads\n"
+            << "\t--entries <start>:<stop>     : Only convert entries "
+               "[start, stop), either may be omitted\n"
             << std::endl;
 }
 
+void ParseEntries(std::string const &arg) {
+  auto colon = arg.find(':');
+  if (colon == std::string::npos) {
+    std::cout << "[ERROR]: --entries expects <start>:<stop>, but was passed "
+              << arg << std::endl;
+    exit(1);
+  }
+  if (colon > 0) {
+    entry_begin = std::stoul(arg.substr(0, colon));
+  }
+  if ((colon + 1) < arg.size()) {
+    entry_end = std::stoul(arg.substr(colon + 1));
+  }
+  std::cout << "[INFO]: Converting entries [" << entry_begin << ", "
+            << ((entry_end == std::numeric_limits<size_t>::max())
+                    ? std::string("end")
+                    : std::to_string(entry_end))
+            << ")" << std::endl;
+}
+
 void handleOpts(int argc, char const *argv[]) {
   int opt = 1;
   while (opt < argc) {
@@ -39,6 +82,12 @@ void handleOpts(int argc, char const *argv[]) {
       } else if (std::string(argv[opt]) == "-p") {
         plugin_name = argv[++opt];
         std::cout << "[INFO]: Reading with plugin " << plugin_name << std::endl;
+      } else if (std::string(argv[opt]) == "-j") {
+        nthreads = std::max(std::stoul(argv[++opt]), 1ul);
+        std::cout << "[INFO]: Decoding with " << nthreads << " threads"
+                  << std::endl;
+      } else if (std::string(argv[opt]) == "--entries") {
+        ParseEntries(argv[++opt]);
       } else {
         std::cout << "[ERROR]: Unknown option: " << argv[opt] << std::endl;
         SayUsage(argv);
@@ -53,6 +102,148 @@ void handleOpts(int argc, char const *argv[]) {
   }
 }
 
+using EventBlock = std::vector<std::shared_ptr<HepMC3::GenEvent>>;
+
+// Blocks are decoded out of order by the workers and handed to the writer in
+// order. Workers block once they get too far ahead of the writer.
+class OrderedBlockQueue {
+  std::mutex m;
+  std::condition_variable pushed;
+  std::condition_variable popped;
+  std::map<size_t, EventBlock> blocks;
+  size_t next_block;
+  size_t nblocks;
+  size_t max_in_flight;
+  std::exception_ptr error;
+
+public:
+  OrderedBlockQueue(size_t nblocks, size_t max_in_flight)
+      : next_block{0}, nblocks{nblocks}, max_in_flight{max_in_flight} {}
+
+  // returns false if the writer has given up
+  bool push(size_t block, EventBlock &&evs) {
+    std::unique_lock<std::mutex> lk(m);
+    popped.wait(lk, [&] {
+      return error || (block < (next_block + max_in_flight));
+    });
+    if (error) {
+      return false;
+    }
+    blocks[block] = std::move(evs);
+    lk.unlock();
+    pushed.notify_all();
+    return true;
+  }
+
+  void fail(std::exception_ptr ex) {
+    {
+      std::unique_lock<std::mutex> lk(m);
+      if (!error) {
+        error = ex;
+      }
+    }
+    pushed.notify_all();
+    popped.notify_all();
+  }
+
+  // returns false once every block has been popped
+  bool pop(EventBlock &evs) {
+    std::unique_lock<std::mutex> lk(m);
+    pushed.wait(lk, [&] {
+      return error || (next_block >= nblocks) || blocks.count(next_block);
+    });
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    if (next_block >= nblocks) {
+      return false;
+    }
+    evs = std::move(blocks[next_block]);
+    blocks.erase(next_block++);
+    lk.unlock();
+    popped.notify_all();
+    return true;
+  }
+};
+
+class ThroughputReport {
+  std::chrono::steady_clock::time_point start;
+  size_t nwritten;
+
+  double elapsed() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+  }
+
+  // the writer buffers, so this lags slightly behind until it is closed
+  double mb_written() const {
+    std::error_code ec;
+    auto nbytes = std::filesystem::file_size(file_to_write, ec);
+    return ec ? 0 : double(nbytes) / (1024.0 * 1024.0);
+  }
+
+public:
+  ThroughputReport()
+      : start{std::chrono::steady_clock::now()}, nwritten{0} {}
+
+  void written(size_t n) {
+    size_t before = nwritten / report_every;
+    nwritten += n;
+    if ((nwritten / report_every) != before) {
+      report("Written");
+    }
+  }
+
+  void report(std::string const &what) const {
+    double t = std::max(elapsed(), 1E-9);
+    nuis::log_info("{} {} events in {:.1f} s: {:.1f} events/s, {:.2f} MB/s",
+                   what, nwritten, t, double(nwritten) / t, mb_written() / t);
+  }
+};
+
+// Non-seekable inputs are read by a single source on a read-ahead thread, so
+// that decoding still overlaps with writing.
+int ConvertSerial(YAML::Node cfg) {
+  cfg["read_ahead"] = true;
+  if (nthreads > 1) {
+    // HepMC3 ASCII inputs can still be parsed on several threads
+    cfg["parallel_parse_threads"] = nthreads;
+  }
+  if ((entry_begin > 0) ||
+      (entry_end != std::numeric_limits<size_t>::max())) {
+    cfg["entry_range"] = std::vector<size_t>{entry_begin, entry_end};
+  }
+
+  nuis::EventSourceFactory fact;
+  auto [gri, evs] = fact.make_unnormalized(cfg);
+  if (!evs) {
+    nuis::log_critical("Failed to find EventSource for input files {}",
+                       files_to_read);
+    return 1;
+  }
+
+  auto wrtr = NuHepMC::Writer::make_writer(file_to_write, gri);
+  ThroughputReport rep;
+  auto ev = evs->first();
+  if (ev) {
+    ev->set_run_info(gri);
+    wrtr->write_event(*ev);
+    rep.written(1);
+  }
+  EventBlock block;
+  while (ev && evs->next_batch(block, block_size)) {
+    for (auto &ev : block) {
+      ev->set_run_info(gri);
+      wrtr->write_event(*ev);
+    }
+    rep.written(block.size());
+  }
+  wrtr->close();
+  rep.report("Converted");
+  return 0;
+}
+
 int main(int argc, char const *argv[]) {
 
   handleOpts(argc, argv);
@@ -67,9 +258,11 @@ int main(int argc, char const *argv[]) {
     cfg["plugin_name"] = plugin_name;
   }
   cfg["filepaths"] = files_to_read;
+  // sources are driven from threads other than the one that built them
+  cfg["thread_safe"] = true;
 
   nuis::EventSourceFactory fact;
-  auto [gri, evs] = fact.make(cfg);
+  auto [gri, evs] = fact.make_unnormalized(YAML::Clone(cfg));
 
   if (!evs) {
     nuis::log_critical("Failed to find EventSource for input files {}",
@@ -77,10 +270,82 @@ int main(int argc, char const *argv[]) {
     return 1;
   }
 
-  auto wrtr = NuHepMC::Writer::make_writer(file_to_write, gri);
-  for (auto [ev, cvw] : evs) {
-    ev->set_run_info(gri);
-    wrtr->write_event(*ev);
+  if (!evs->seekable()) {
+    nuis::log_info("Input is not seekable, it will be decoded by a single "
+                   "read-ahead source.");
+    evs.reset();
+    return ConvertSerial(cfg);
   }
-  wrtr->close();
-}
\ No newline at end of file
+
+  entry_end = std::min(entry_end, evs->size());
+  size_t nentries = (entry_end > entry_begin) ? (entry_end - entry_begin) : 0;
+  size_t nblocks = (nentries + block_size - 1) / block_size;
+  nthreads = std::max(std::min(nthreads, nblocks), size_t(1));
+
+  // each worker needs its own source, worker i decodes blocks i, i+N, ...
+  std::vector<nuis::IEventSourcePtr> worker_sources{evs};
+  while (worker_sources.size() < nthreads) {
+    auto [wgri, wevs] = fact.make_unnormalized(YAML::Clone(cfg));
+    if (!wevs || !wevs->seekable()) {
+      nuis::log_critical("Failed to build event source for worker {}",
+                         worker_sources.size());
+      return 1;
+    }
+    worker_sources.push_back(wevs);
+  }
+
+  OrderedBlockQueue queue(nblocks, 4 * nthreads);
+  std::vector<std::thread> workers;
+  for (size_t wi = 0; wi < nthreads; ++wi) {
+    workers.emplace_back([&, wi]() {
+      try {
+        auto &wevs = worker_sources[wi];
+        for (size_t bi = wi; bi < nblocks; bi += nthreads) {
+          size_t bbegin = entry_begin + bi * block_size;
+          size_t blen = std::min(block_size, entry_end - bbegin);
+          EventBlock block;
+          if (wevs->seek(bbegin)) {
+            wevs->next_batch(block, blen);
+          }
+          // a short block would silently drop events from the output
+          if (block.size() != blen) {
+            throw ShortEventBlock()
+                << "Worker " << wi << " read " << block.size() << "/" << blen
+                << " events from the block starting at entry " << bbegin;
+          }
+          if (!queue.push(bi, std::move(block))) {
+            return;
+          }
+        }
+      } catch (...) {
+        queue.fail(std::current_exception());
+      }
+    });
+  }
+
+  int rtn = 0;
+  try {
+    auto wrtr = NuHepMC::Writer::make_writer(file_to_write, gri);
+    ThroughputReport rep;
+    EventBlock block;
+    while (queue.pop(block)) {
+      for (auto &ev : block) {
+        ev->set_run_info(gri);
+        wrtr->write_event(*ev);
+      }
+      rep.written(block.size());
+      block.clear();
+    }
+    wrtr->close();
+    rep.report("Converted");
+  } catch (std::exception const &ex) {
+    nuis::log_critical("Conversion failed: {}", ex.what());
+    queue.fail(std::current_exception());
+    rtn = 1;
+  }
+
+  for (auto &w : workers) {
+    w.join();
+  }
+  return rtn;
+}
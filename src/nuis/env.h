@@ -11,7 +11,7 @@ DECLARE_NUISANCE_EXCEPT(EnvVarNotDefined);
 namespace env {
 
 #define NEW_NUISANCE_ENVVAR(A)                                                 \
-  std::string A() {                                                                   \
+  inline std::string A() {                                                     \
     auto A_val = std::getenv(#A);                                              \
     if (!A_val) {                                                              \
       throw EnvVarNotDefined() << "Environment variable: " << #A               \
@@ -19,7 +19,7 @@ namespace env {
     }                                                                          \
     return A_val;                                                              \
   }                                                                            \
-  std::string A(std::string const &default_val) {                                     \
+  inline std::string A(std::string const &default_val) {                       \
     auto A_val = std::getenv(#A);                                              \
     if (!A_val) {                                                              \
       return default_val;                                                      \
@@ -30,6 +30,8 @@ namespace env {
 NEW_NUISANCE_ENVVAR(NUISANCE3_ROOT);
 NEW_NUISANCE_ENVVAR(NUISANCEDB);
 NEW_NUISANCE_ENVVAR(NUISANCE_EVENT_PATH);
+NEW_NUISANCE_ENVVAR(NUISANCE_EVENT_CACHE_DIR);
+NEW_NUISANCE_ENVVAR(NUISANCE_GENIE_SPLINE_CACHE_DIR);
 
 #undef NEW_NUISANCE_ENVVAR
 
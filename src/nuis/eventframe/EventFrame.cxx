@@ -80,6 +80,32 @@ EventFrame EventFrame::bottomRows(size_t rows) const {
   return {column_names, table.bottomRows(rows), rows};
 }
 
+EventFrame EventFrame::Concatenate(std::vector<EventFrame> const &frames) {
+  if (!frames.size()) {
+    return {{}, Eigen::ArrayXXd(0, 0), 0};
+  }
+
+  size_t nrows = 0;
+  for (auto const &f : frames) {
+    if (f.column_names != frames.front().column_names) {
+      throw InvalidFrameColumnName()
+          << fmt::format("EventFrame::Concatenate passed frames with different "
+                         "columns: {} and {}",
+                         frames.front().column_names, f.column_names);
+    }
+    nrows += f.table.rows();
+  }
+
+  Eigen::ArrayXXd table(nrows, frames.front().column_names.size());
+  size_t first_row = 0;
+  for (auto const &f : frames) {
+    table.middleRows(first_row, f.table.rows()) = f.table;
+    first_row += f.table.rows();
+  }
+
+  return {frames.front().column_names, table, nrows};
+}
+
 std::ostream &operator<<(std::ostream &os, nuis::EventFramePrinter fp) {
 
   size_t abs_max_width = fp.max_col_width;
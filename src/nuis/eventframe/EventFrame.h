@@ -44,6 +44,10 @@ struct EventFrame {
   EventFrame topRows(size_t rows) const;
   EventFrame bottomRows(size_t rows) const;
 
+  // Concatenates frames with identical columns, in order, with a single copy
+  // of each frame
+  static EventFrame Concatenate(std::vector<EventFrame> const &frames);
+
   explicit operator bool() const { return table.rows(); }
 };
 
@@ -1,5 +1,8 @@
 #include "nuis/eventframe/EventFrameGen.h"
 
+#include "nuis/eventinput/EventSourceFactory.h"
+#include "nuis/eventinput/IEventSource.h"
+
 #include "NuHepMC/ReaderUtils.hxx"
 #include "NuHepMC/UnitsUtils.hxx"
 
@@ -9,6 +12,11 @@
 #include "nuis/log.txx"
 
 #include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 #define COLUMN_TYPE_ITER                                                       \
   X(bool)                                                                      \
@@ -19,8 +27,19 @@
   X(float)                                                                     \
   X(double)
 
-DECLARE_NUISANCE_EXCEPT(InvalidFrameColumnType);
 DECLARE_NUISANCE_EXCEPT(AttemptRestartFailedFrame);
+DECLARE_NUISANCE_EXCEPT(InvalidFrameEventSource);
+
+using RowMajorArrayXXd =
+    Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// the number of entries in the row-major staging tile used by
+// EventFrameGen::next, sized to stay in L2 cache
+static size_t const frame_tile_size = 32768;
+
+// the number of events per thread in each batch read by
+// EventFrameGen::next_threaded
+static size_t const thread_batch_size = 1024;
 
 static std::vector<std::string> const default_efg_columns{
     "event.number", "weight.cv", "fatx_per_sumw.pb_per_target.estimate",
@@ -28,18 +47,122 @@ static std::vector<std::string> const default_efg_columns{
 
 namespace nuis {
 
+namespace {
+// A fixed set of threads that each run the same job once per call to start(),
+// so that threads are not started for every batch.
+class BatchWorkers {
+  std::vector<std::thread> threads;
+  std::mutex m;
+  std::condition_variable work_cv;
+  std::condition_variable done_cv;
+  std::function<void(size_t)> job;
+  size_t generation;
+  size_t nbusy;
+  bool stop;
+
+  void work(size_t ti) {
+    size_t last_generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lk(m);
+        work_cv.wait(lk,
+                     [&] { return stop || (generation != last_generation); });
+        if (stop) {
+          return;
+        }
+        last_generation = generation;
+      }
+      job(ti);
+      {
+        std::unique_lock<std::mutex> lk(m);
+        if (--nbusy) {
+          continue;
+        }
+      }
+      done_cv.notify_all();
+    }
+  }
+
+public:
+  explicit BatchWorkers(size_t n) : generation{0}, nbusy{0}, stop{false} {
+    for (size_t ti = 0; ti < n; ++ti) {
+      threads.emplace_back([this, ti]() { work(ti); });
+    }
+  }
+
+  // runs j(ti) on every thread and returns without waiting for them, j must
+  // not throw
+  void start(std::function<void(size_t)> j) {
+    {
+      std::unique_lock<std::mutex> lk(m);
+      job = std::move(j);
+      nbusy = threads.size();
+      ++generation;
+    }
+    work_cv.notify_all();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lk(m);
+    done_cv.wait(lk, [&] { return !nbusy; });
+  }
+
+  ~BatchWorkers() {
+    wait();
+    {
+      std::unique_lock<std::mutex> lk(m);
+      stop = true;
+    }
+    work_cv.notify_all();
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+};
+} // namespace
+
+NormalizedEventSourcePtr MakeFrameEventSource(YAML::Node const &cfg) {
+  auto [gri, evs] = EventSourceFactory().make(cfg);
+  if (!evs) {
+    throw InvalidFrameEventSource()
+        << "EventSourceFactory failed to build an event source from: "
+        << YAML::Dump(cfg);
+  }
+  return evs;
+}
+
 EventFrameGen::EventFrameGen(NormalizedEventSourcePtr evs, size_t block_size)
-    : in_error_state(false), source(evs), chunk_size{block_size},
+    : in_error_state(false), source(evs), nshards{1}, chunk_size{block_size},
       max_events_to_loop{std::numeric_limits<size_t>::max()},
-      progress_report_every{std::numeric_limits<size_t>::max()},
-      ev_it(nullptr) {
-  auto run_info = evs->first().value().evt->run_info();
+      progress_report_every{std::numeric_limits<size_t>::max()}, nthreads{1},
+      ev_it(nullptr) {}
+
+EventFrameGen::EventFrameGen(YAML::Node const &cfg, size_t nshrds,
+                             size_t block_size)
+    : EventFrameGen(MakeFrameEventSource(cfg), block_size) {
+  source_cfg = YAML::Clone(cfg);
+  nshards = std::max(nshrds, size_t(1));
 }
 
 EventFrameGen EventFrameGen::filter(FilterFunc filt) {
   filters.push_back(filt);
   return *this;
 }
+EventFrameGen EventFrameGen::prefilter(EventHeaderFilterFunc filt) {
+  if (header_filter) {
+    header_filter = [=, prev = header_filter](EventHeader const &hdr) {
+      return prev(hdr) && filt(hdr);
+    };
+  } else {
+    header_filter = filt;
+  }
+  if (source && !source->set_prefilter(header_filter)) {
+    log_debug("EventFrameGen::prefilter() event source cannot apply the "
+              "prefilter before conversion, it will be applied to converted "
+              "events.");
+  }
+  return *this;
+}
 EventFrameGen EventFrameGen::limit(size_t nmax) {
   max_events_to_loop = nmax;
   return *this;
@@ -49,6 +172,10 @@ EventFrameGen EventFrameGen::progress(size_t every) {
   set_log_level(log_level::info);
   return *this;
 }
+EventFrameGen EventFrameGen::threads(size_t n) {
+  nthreads = std::max(n, size_t(1));
+  return *this;
+}
 
 EventFrame EventFrameGen::first(size_t nchunk) {
   if (in_error_state) {
@@ -70,20 +197,62 @@ EventFrame EventFrameGen::first(size_t nchunk) {
   return next(nchunk);
 }
 
+template <typename RT>
+std::pair<RT const *, size_t>
+EventFrameGen::project_into_scratch(ProjectionScratch &scr,
+                                    HepMC3::GenEvent const &ev,
+                                    size_t proj_index, size_t ncols) {
+  auto &buff = scr.get<RT>();
+  if (size_t(buff.size()) < ncols) {
+    buff.resize(ncols);
+  }
+  size_t nfilled =
+      get_proj_functions<RT>()[proj_index](ev, buff.data(), ncols);
+  return {buff.data(), std::min(nfilled, ncols)};
+}
+
 template <typename T>
-size_t EventFrameGen::fill_row_columns(Eigen::ArrayXdRef row,
+size_t EventFrameGen::fill_row_columns(ProjectionScratch &scr,
+                                       Eigen::ArrayXdRef row,
                                        HepMC3::GenEvent const &ev,
                                        size_t proj_index, size_t first_col,
                                        size_t ncols_to_fill) {
-  auto const &projs = get_proj_functions<T>()[proj_index](ev);
+  auto [projs, nfilled] =
+      project_into_scratch<T>(scr, ev, proj_index, ncols_to_fill);
 
-  for (size_t i = 0; i < std::min(projs.size(), ncols_to_fill); ++i) {
+  for (size_t i = 0; i < nfilled; ++i) {
     row[first_col++] = projs[i];
   }
 
   return first_col;
 }
 
+void EventFrameGen::fill_projected_row(ProjectionScratch &scr,
+                                       Eigen::ArrayXdRef row,
+                                       HepMC3::GenEvent const &ev) {
+  size_t col_id = default_efg_columns.size();
+  for (auto &[column_names, typenum, proj_index] : columns) {
+    size_t next_col_id = col_id;
+
+    switch (typenum) {
+#define X(t)                                                                   \
+  case column_type<t>::id:                                                     \
+    next_col_id = fill_row_columns<t>(scr, row, ev, proj_index, col_id,        \
+                                      column_names.size());                    \
+    break;
+
+      COLUMN_TYPE_ITER
+
+#undef X
+    }
+
+    for (size_t i = next_col_id; i < (col_id + column_names.size()); ++i) {
+      row[i] = kMissingDatum<double>;
+    }
+    col_id += column_names.size();
+  }
+}
+
 EventFrame EventFrameGen::next(size_t nchunk) {
   if (in_error_state) {
     throw AttemptRestartFailedFrame();
@@ -100,10 +269,26 @@ EventFrame EventFrameGen::next(size_t nchunk) {
     return {all_column_names, Eigen::ArrayXXd(0, all_column_names.size()), 0};
   }
 
+  if (nthreads > 1) {
+    return next_threaded(nchunk);
+  }
+
   Eigen::ArrayXXd chunk(nchunk, all_column_names.size());
 
   size_t chunk_row = 0;
 
+  // rows are staged in a small row-major tile, so that each event writes to
+  // contiguous memory, and each full tile is copied into the column-major
+  // chunk in one pass
+  size_t tile_rows = std::min(
+      nchunk, std::max(size_t(64), frame_tile_size / all_column_names.size()));
+  RowMajorArrayXXd tile(tile_rows, all_column_names.size());
+  size_t tile_row = 0;
+  auto flush_tile = [&]() {
+    chunk.middleRows(chunk_row - tile_row, tile_row) = tile.topRows(tile_row);
+    tile_row = 0;
+  };
+
   auto end_it = end(source);
 
   const auto start{std::chrono::steady_clock::now()};
@@ -144,41 +329,24 @@ EventFrame EventFrameGen::next(size_t nchunk) {
     auto [fatx_pn, sumweights_pn, nevents_pn] =
         source->norm_info(NuHepMC::CrossSection::Units::pb_PerNucleon);
 
-    chunk(chunk_row, 0) = ev.event_number();
-    chunk(chunk_row, 1) = cvw;
-    chunk(chunk_row, 2) = fatx_pt / sumweights_pt;
-    chunk(chunk_row, 3) = fatx_pn / sumweights_pn;
-    chunk(chunk_row, 4) = NuHepMC::ER3::ReadProcessID(ev);
+    tile(tile_row, 0) = ev.event_number();
+    tile(tile_row, 1) = cvw;
+    tile(tile_row, 2) = fatx_pt / sumweights_pt;
+    tile(tile_row, 3) = fatx_pn / sumweights_pn;
+    tile(tile_row, 4) = NuHepMC::ER3::ReadProcessID(ev);
 
     NUIS_LOG_TRACE(
         "EventFrameGen::next() chunk_row: {} was kept, event_number: {} ",
         ev.event_number());
 
-    size_t col_id = default_efg_columns.size();
-    for (auto &[column_names, typenum, proj_index] : columns) {
-      size_t next_col_id = col_id;
-
-      switch (typenum) {
-#define X(t)                                                                   \
-  case column_type<t>::id:                                                     \
-    next_col_id = fill_row_columns<t>(chunk.row(chunk_row), ev, proj_index,    \
-                                      col_id, column_names.size());            \
-    break;
-
-        COLUMN_TYPE_ITER
-
-#undef X
-      }
-
-      for (size_t i = next_col_id; i < (col_id + column_names.size()); ++i) {
-        chunk(chunk_row, i) = kMissingDatum<double>;
-      }
-      col_id += column_names.size();
-    }
+    fill_projected_row(scratch, tile.row(tile_row), ev);
 
     n_total_rows++;
     neventsprocessed++;
     chunk_row++;
+    if (++tile_row == tile_rows) {
+      flush_tile();
+    }
     // have to do this before the next loop otherwise we read one too many
     // events
     if (neventsprocessed >= max_events_to_loop) {
@@ -190,6 +358,8 @@ EventFrame EventFrameGen::next(size_t nchunk) {
     ++ev_it;
   }
 
+  flush_tile();
+
   const auto finish{std::chrono::steady_clock::now()};
   const auto elapsed_ms =
       std::chrono::duration_cast<std::chrono::milliseconds>(finish - start)
@@ -217,59 +387,563 @@ EventFrame EventFrameGen::next(size_t nchunk) {
   return {all_column_names, chunk.topRows(chunk_row), chunk_row};
 }
 
+EventFrame EventFrameGen::next_threaded(size_t nchunk) {
+  size_t ncols = all_column_names.size();
+  Eigen::ArrayXXd chunk(nchunk, ncols);
+  size_t chunk_row = 0;
+
+  struct Batch {
+    std::vector<EventCVWeightPair> events;
+    std::vector<char> selected;
+    RowMajorArrayXXd rows;
+  };
+  // one batch is evaluated by the workers while the next is read
+  Batch batches[2];
+  size_t current = 0;
+
+  std::vector<ProjectionScratch> scratches(nthreads);
+  std::vector<std::exception_ptr> errors(nthreads);
+  std::vector<size_t> error_rows(nthreads, 0);
+
+  auto end_it = end(source);
+
+  // batches never read more events than there are rows left in the chunk
+  // after every event in the batch being evaluated, so every selected row fits
+  auto read_batch = [&](Batch &b, size_t nin_flight) {
+    size_t nbatch =
+        std::min({nthreads * thread_batch_size, nchunk - chunk_row - nin_flight,
+                  max_events_to_loop - neventsprocessed});
+
+    // reading and the normalization stay on this thread, in input order
+    b.events.clear();
+    b.rows.resize(nbatch, ncols);
+    while ((b.events.size() < nbatch) && (ev_it != end_it)) {
+      auto const &evcvw = *ev_it;
+      auto [fatx_pt, sumweights_pt, nevents_pt] =
+          source->norm_info(NuHepMC::CrossSection::Units::pb_PerAtom);
+      auto [fatx_pn, sumweights_pn, nevents_pn] =
+          source->norm_info(NuHepMC::CrossSection::Units::pb_PerNucleon);
+
+      size_t bi = b.events.size();
+      b.rows(bi, 0) = evcvw.evt->event_number();
+      b.rows(bi, 1) = evcvw.cv_weight;
+      b.rows(bi, 2) = fatx_pt / sumweights_pt;
+      b.rows(bi, 3) = fatx_pn / sumweights_pn;
+      b.rows(bi, 4) = NuHepMC::ER3::ReadProcessID(*evcvw.evt);
+
+      b.events.push_back(evcvw);
+      ++ev_it;
+    }
+    neventsprocessed += b.events.size();
+    b.selected.assign(b.events.size(), 0);
+  };
+
+  // each thread evaluates a contiguous slice of the batch
+  auto evaluate_slice = [&](Batch &b, size_t ti) {
+    size_t slice = (b.events.size() + nthreads - 1) / nthreads;
+    size_t bi = std::min(ti * slice, b.events.size());
+    size_t slice_end = std::min(bi + slice, b.events.size());
+    try {
+      for (; bi < slice_end; ++bi) {
+        auto const &ev = *b.events[bi].evt;
+        bool cut = false;
+        for (auto &filt : filters) {
+          if (!filt(ev)) {
+            cut = true;
+            break;
+          }
+        }
+        if (cut) {
+          continue;
+        }
+        b.selected[bi] = 1;
+        fill_projected_row(scratches[ti], b.rows.row(bi), ev);
+      }
+    } catch (...) {
+      errors[ti] = std::current_exception();
+      error_rows[ti] = bi;
+    }
+  };
+
+  const auto start{std::chrono::steady_clock::now()};
+
+  // declared after the batches so that the workers are joined first
+  BatchWorkers workers(nthreads);
+  size_t nevaluated = neventsprocessed;
+
+  read_batch(batches[current], 0);
+  while (batches[current].events.size()) {
+    Batch &b = batches[current];
+    workers.start([&](size_t ti) { evaluate_slice(b, ti); });
+
+    Batch &next_b = batches[1 - current];
+    read_batch(next_b, b.events.size());
+
+    workers.wait();
+
+    for (size_t ti = 0; ti < nthreads; ++ti) {
+      if (errors[ti]) {
+        log_error("EventFrameGen::next() failed evaluating filters or "
+                  "projections on event {}.",
+                  b.events[error_rows[ti]].evt->event_number());
+        error_event = *b.events[error_rows[ti]].evt;
+        in_error_state = true;
+        std::rethrow_exception(errors[ti]);
+      }
+    }
+
+    // compact the selected rows, keeping input order, and copy them into the
+    // chunk in one pass
+    size_t nselected = 0;
+    for (size_t bi = 0; bi < b.events.size(); ++bi) {
+      if (!b.selected[bi]) {
+        continue;
+      }
+      if (bi != nselected) {
+        b.rows.row(nselected) = b.rows.row(bi);
+      }
+      nselected++;
+    }
+    chunk.middleRows(chunk_row, nselected) = b.rows.topRows(nselected);
+    chunk_row += nselected;
+    n_total_rows += nselected;
+    nevaluated += b.events.size();
+
+    if (progress_report_every &&
+        ((nevaluated / progress_report_every) !=
+         ((nevaluated - b.events.size()) / progress_report_every))) {
+      log_info("EventFrameGen has selected {} from {} processed events.",
+               n_total_rows, nevaluated);
+    }
+
+    current = 1 - current;
+    // the read-ahead is empty if the chunk could not fit it while the last
+    // batch was evaluated
+    if (!batches[current].events.size()) {
+      read_batch(batches[current], 0);
+    }
+  }
+
+  const auto finish{std::chrono::steady_clock::now()};
+
+  if (chunk_row) {
+    // reset the last fatx entries to be the final best estimate, see next()
+    auto [fatx_pt, sumweights_pt, nevents_pt] =
+        source->norm_info(NuHepMC::CrossSection::Units::pb_PerAtom);
+    auto [fatx_pn, sumweights_pn, nevents_pn] =
+        source->norm_info(NuHepMC::CrossSection::Units::pb_PerNucleon);
+    chunk(chunk_row - 1, 2) = fatx_pt / sumweights_pt;
+    chunk(chunk_row - 1, 3) = fatx_pn / sumweights_pn;
+  }
+
+  log_info("EventFrameGen::next() done looping on {} threads n_total_rows: {} "
+           "neventsprocessed: {} in {} ms. chunk_row: {}",
+           nthreads, n_total_rows, neventsprocessed,
+           std::chrono::duration_cast<std::chrono::milliseconds>(finish - start)
+               .count(),
+           chunk_row);
+
+  return {all_column_names, chunk.topRows(chunk_row), chunk_row};
+}
+
 EventFrame EventFrameGen::all() {
   if (in_error_state) {
     throw AttemptRestartFailedFrame();
   }
 
+  if (nshards > 1) {
+    auto ranges = shard_entry_ranges();
+    if (ranges.size() > 1) {
+      return all_sharded(ranges);
+    }
+  }
+
   log_info("EventFrameGen::all Chunk shape: {} rows {} cols, {} KB.",
            chunk_size, all_column_names.size(),
            ((chunk_size * all_column_names.size()) * sizeof(double)) / 1024);
 
-  Eigen::ArrayXXd next_chunk = first().table;
+  // chunks are kept until the end and copied into the output once, rather
+  // than growing the output for every chunk
+  std::vector<EventFrame> chunks;
+  size_t nrows = 0;
+  size_t last_report_size = 0;
 
-  Eigen::ArrayXXd builder = Eigen::ArrayXXd::Zero(0, next_chunk.cols());
+  for (auto chunk = first(); chunk.table.rows(); chunk = next()) {
+    log_trace("EventFrameGen::all() got chunk with {} rows {} cols.",
+              chunk.table.rows(), chunk.table.cols());
 
-  log_trace("EventFrameGen::all() first with nrows {}", next_chunk.rows());
+    nrows += chunk.table.rows();
+    chunks.push_back(std::move(chunk));
 
-  size_t last_report_size = 0;
-  if ((neventsprocessed - last_report_size) > progress_report_every) {
-    log_info("EventFrameGen::all() is using ~{} MB of memory. Output "
-             "EventFrame will be {} MB.",
-             ((builder.size() * 2 + next_chunk.size()) * sizeof(double)) /
-                 (1024 * 1024),
-             (builder.size() * sizeof(double)) / (1024 * 1024));
-    last_report_size = builder.rows() + next_chunk.rows();
+    if ((neventsprocessed - last_report_size) > progress_report_every) {
+      log_info("EventFrameGen::all() holds {} chunks of ~{} MB in total, "
+               "concatenating them will briefly need twice that.",
+               chunks.size(),
+               (nrows * all_column_names.size() * sizeof(double)) /
+                   (1024 * 1024));
+      last_report_size = neventsprocessed;
+    }
+  }
+
+  if (!chunks.size()) {
+    return {all_column_names, Eigen::ArrayXXd(0, all_column_names.size()), 0};
   }
 
-  while (next_chunk.rows()) {
-    log_trace("EventFrameGen::all() got chunk with {} rows {} cols, adding to "
-              "existing block with {} rows {} cols.",
-              next_chunk.rows(), next_chunk.cols(), builder.rows(),
-              builder.cols());
+  auto frame = EventFrame::Concatenate(chunks);
 
-    Eigen::ArrayXXd new_builder(builder.rows() + next_chunk.rows(),
-                                next_chunk.cols());
-    new_builder.topRows(builder.rows()) = builder;
-    new_builder.bottomRows(next_chunk.rows()) = next_chunk;
+  log_trace("EventFrameGen::all() done: nrows {}", frame.table.rows());
 
-    builder = new_builder;
+  return frame;
+}
 
-    next_chunk = next().table;
+TypedEventFrame EventFrameGen::make_typed_frame(size_t nrows) {
+  TypedEventFrame frame;
+  frame.num_rows = nrows;
+  frame.add_column<int>(default_efg_columns[0]);
+  frame.add_column<double>(default_efg_columns[1]);
+  frame.add_column<double>(default_efg_columns[2]);
+  frame.add_column<double>(default_efg_columns[3]);
+  frame.add_column<int>(default_efg_columns[4]);
 
-    if ((neventsprocessed - last_report_size) > progress_report_every) {
-      log_info("EventFrameGen::all() is using ~{} MB of memory. Output "
-               "EventFrame will be {} MB.",
-               ((builder.size() * 2 + next_chunk.size()) * sizeof(double)) /
-                   (1024 * 1024),
-               (builder.size() * sizeof(double)) / (1024 * 1024));
-      last_report_size = builder.rows() + next_chunk.rows();
+  for (auto &[column_names, typenum, proj_index] : columns) {
+    for (auto const &name : column_names) {
+      switch (typenum) {
+#define X(t)                                                                   \
+  case column_type<t>::id:                                                     \
+    frame.add_column<t>(name);                                                 \
+    break;
+
+        COLUMN_TYPE_ITER
+#undef X
+      default:
+        throw InvalidFrameColumnType();
+      }
     }
   }
+  return frame;
+}
+
+template <typename T>
+void EventFrameGen::fill_typed_columns(TypedEventFrame &frame, size_t row,
+                                       HepMC3::GenEvent const &ev,
+                                       size_t proj_index, size_t first_col,
+                                       size_t ncols_to_fill) {
+  auto [projs, nfilled] =
+      project_into_scratch<T>(scratch, ev, proj_index, ncols_to_fill);
 
-  log_trace("EventFrameGen::all() done: nrows {}", builder.rows());
+  size_t i = 0;
+  for (; i < nfilled; ++i) {
+    frame.col<T>(TypedEventFrame::column_t(first_col + i))[row] = projs[i];
+  }
+  for (; i < ncols_to_fill; ++i) {
+    frame.col<T>(TypedEventFrame::column_t(first_col + i))[row] =
+        kMissingDatum<T>;
+  }
+}
+
+TypedEventFrame EventFrameGen::firstTyped(size_t nchunk) {
+  if (in_error_state) {
+    throw AttemptRestartFailedFrame();
+  }
+  all_column_names =
+      std::accumulate(columns.begin(), columns.end(), default_efg_columns,
+                      [](auto cols, auto const &hcp) {
+                        for (auto h : hcp.column_names) {
+                          cols.push_back(h);
+                        }
+                        return cols;
+                      });
+
+  n_total_rows = 0;
+  neventsprocessed = 0;
+  ev_it = begin(source);
+
+  return nextTyped(nchunk);
+}
+
+TypedEventFrame EventFrameGen::nextTyped(size_t nchunk) {
+  if (in_error_state) {
+    throw AttemptRestartFailedFrame();
+  }
+
+  if (nchunk == std::numeric_limits<size_t>::max()) {
+    nchunk = chunk_size;
+  }
+
+  log_info(
+      "EventFrameGen::nextTyped() neventsprocessed: {}, max_events_to_loop: {}",
+      neventsprocessed, max_events_to_loop);
+
+  if (neventsprocessed >= max_events_to_loop) {
+    return make_typed_frame(0);
+  }
+
+  TypedEventFrame chunk = make_typed_frame(nchunk);
+  auto &evnum_col = chunk.col<int>(TypedEventFrame::column_t(0));
+  auto &cvw_col = chunk.col<double>(TypedEventFrame::column_t(1));
+  auto &fatx_pt_col = chunk.col<double>(TypedEventFrame::column_t(2));
+  auto &fatx_pn_col = chunk.col<double>(TypedEventFrame::column_t(3));
+  auto &procid_col = chunk.col<int>(TypedEventFrame::column_t(4));
+
+  size_t chunk_row = 0;
+
+  auto end_it = end(source);
+
+  while (ev_it != end_it) {
+    auto const &[evp, cvw] = *ev_it;
+    auto const &ev = *evp;
+
+    if (neventsprocessed && progress_report_every &&
+        !(neventsprocessed % progress_report_every)) {
+      log_info("EventFrameGen has selected {} from {} processed events.",
+               n_total_rows, neventsprocessed);
+    }
+
+    bool cut = false;
+    for (auto &filt : filters) {
+      if (!filt(ev)) {
+        cut = true;
+        break;
+      }
+    }
+    if (cut) {
+      // have to do this before the next loop otherwise we read one too many
+      // events
+      if (++neventsprocessed >= max_events_to_loop) {
+        break;
+      }
+      ++ev_it;
+      continue;
+    }
+
+    auto [fatx_pt, sumweights_pt, nevents_pt] =
+        source->norm_info(NuHepMC::CrossSection::Units::pb_PerAtom);
+    auto [fatx_pn, sumweights_pn, nevents_pn] =
+        source->norm_info(NuHepMC::CrossSection::Units::pb_PerNucleon);
+
+    evnum_col[chunk_row] = ev.event_number();
+    cvw_col[chunk_row] = cvw;
+    fatx_pt_col[chunk_row] = fatx_pt / sumweights_pt;
+    fatx_pn_col[chunk_row] = fatx_pn / sumweights_pn;
+    procid_col[chunk_row] = NuHepMC::ER3::ReadProcessID(ev);
+
+    size_t col_id = default_efg_columns.size();
+    for (auto &[column_names, typenum, proj_index] : columns) {
+      switch (typenum) {
+#define X(t)                                                                   \
+  case column_type<t>::id:                                                     \
+    fill_typed_columns<t>(chunk, chunk_row, ev, proj_index, col_id,            \
+                          column_names.size());                                \
+    break;
+
+        COLUMN_TYPE_ITER
+
+#undef X
+      }
+      col_id += column_names.size();
+    }
+
+    n_total_rows++;
+    neventsprocessed++;
+    chunk_row++;
+    // have to do this before the next loop otherwise we read one too many
+    // events
+    if (neventsprocessed >= max_events_to_loop) {
+      break;
+    }
+    if (chunk_row >= nchunk) {
+      break;
+    }
+    ++ev_it;
+  }
+
+  if (chunk_row) {
+    // reset the last fatx entries to be the final best estimate, see next()
+    auto [fatx_pt, sumweights_pt, nevents_pt] =
+        source->norm_info(NuHepMC::CrossSection::Units::pb_PerAtom);
+    auto [fatx_pn, sumweights_pn, nevents_pn] =
+        source->norm_info(NuHepMC::CrossSection::Units::pb_PerNucleon);
+    fatx_pt_col[chunk_row - 1] = fatx_pt / sumweights_pt;
+    fatx_pn_col[chunk_row - 1] = fatx_pn / sumweights_pn;
+  }
+
+  log_info("EventFrameGen::nextTyped() done looping n_total_rows: {} "
+           "neventsprocessed: {} chunk_row: {}",
+           n_total_rows, neventsprocessed, chunk_row);
+
+  ++ev_it;
+
+  chunk.conservativeResize(chunk_row);
+  return chunk;
+}
+
+TypedEventFrame EventFrameGen::allTyped() {
+  if (in_error_state) {
+    throw AttemptRestartFailedFrame();
+  }
+
+  std::vector<TypedEventFrame> chunks;
+  for (auto chunk = firstTyped(); chunk; chunk = nextTyped()) {
+    chunks.push_back(std::move(chunk));
+  }
+  if (!chunks.size()) {
+    return make_typed_frame(0);
+  }
+
+  auto frame = TypedEventFrame::Concatenate(chunks);
+  log_info("EventFrameGen::allTyped() done: nrows {}, {} MB.", frame.num_rows,
+           frame.data_size() / (1024 * 1024));
+  return frame;
+}
+
+std::vector<std::pair<size_t, size_t>> EventFrameGen::shard_entry_ranges() {
+  auto evs = source->unwrap();
+  if (!evs || !evs->seekable() || !evs->size()) {
+    log_warn("EventFrameGen: the event source does not support random access, "
+             "cannot shard the input, falling back to a single thread.");
+    return {};
+  }
+
+  size_t range_begin = 0;
+  size_t range_end = evs->size();
+  if (source_cfg["entry_range"]) {
+    auto range = source_cfg["entry_range"].as<std::vector<size_t>>();
+    if (range.size() == 2) {
+      range_begin = range[0];
+      range_end = std::min(range[1], range_end);
+    }
+  }
+
+  if (range_end <= range_begin) {
+    return {};
+  }
+
+  if (max_events_to_loop < (range_end - range_begin)) {
+    range_end = range_begin + max_events_to_loop;
+  }
+
+  size_t nentries = range_end - range_begin;
+  size_t shard_size = (nentries + nshards - 1) / nshards;
+
+  std::vector<std::pair<size_t, size_t>> ranges;
+  for (size_t sb = range_begin; sb < range_end; sb += shard_size) {
+    ranges.emplace_back(sb, std::min(sb + shard_size, range_end));
+  }
+  return ranges;
+}
+
+EventFrame EventFrameGen::all_sharded(
+    std::vector<std::pair<size_t, size_t>> const &ranges) {
+
+  // sources are built serially as plugin construction can touch
+  // generator-global state
+  std::vector<EventFrameGen> workers;
+  for (auto const &[range_begin, range_end] : ranges) {
+    auto shard_cfg = YAML::Clone(source_cfg);
+    shard_cfg["entry_range"] = std::vector<size_t>{range_begin, range_end};
+    shard_cfg["thread_safe"] = true;
+
+    log_debug("EventFrameGen::all_sharded() building shard for entries [{}, "
+              "{})",
+              range_begin, range_end);
+
+    EventFrameGen worker(*this);
+    worker.nshards = 1;
+    worker.nthreads = 1;
+    worker.max_events_to_loop = std::numeric_limits<size_t>::max();
+    worker.source = MakeFrameEventSource(shard_cfg);
+    if (header_filter) {
+      worker.source->set_prefilter(header_filter);
+    }
+    workers.push_back(std::move(worker));
+  }
+
+  log_info("EventFrameGen::all() processing {} shards on {} threads.",
+           workers.size(), workers.size());
+
+  const auto start{std::chrono::steady_clock::now()};
+
+  std::vector<EventFrame> frames(workers.size());
+  std::vector<std::exception_ptr> errors(workers.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < workers.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      try {
+        frames[i] = workers[i].all();
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  for (size_t i = 0; i < workers.size(); ++i) {
+    if (errors[i]) {
+      in_error_state = true;
+      error_event = workers[i].error_event;
+      std::rethrow_exception(errors[i]);
+    }
+  }
+
+  // concatenate in entry order so that the output does not depend on thread
+  // scheduling
+  size_t nrows = 0;
+  for (auto const &frame : frames) {
+    nrows += frame.table.rows();
+  }
+
+  all_column_names = frames.front().column_names;
+  Eigen::ArrayXXd table(nrows, all_column_names.size());
+
+  // each shard estimates fatx = W_k / S_k, where W_k is its sum of weights
+  // and S_k is the sum of w/sigma for per-event cross sections or W_k/sigma
+  // for a run-level cross section. Summing S_k = W_k / fatx_k over the shards
+  // recovers the estimate of a single pass over all of the entries, weighted
+  // means of the shard estimates are only correct for run-level cross
+  // sections.
+  double inv_fatx_pt = 0, inv_fatx_pn = 0, sumweights = 0;
+
+  n_total_rows = 0;
+  neventsprocessed = 0;
+  for (size_t i = 0; i < workers.size(); ++i) {
+    table.middleRows(n_total_rows, frames[i].table.rows()) = frames[i].table;
+    n_total_rows += frames[i].table.rows();
+    neventsprocessed += workers[i].neventsprocessed;
+
+    auto [shard_fatx_pt, shard_sumweights, shard_nevents] =
+        workers[i].source->norm_info(NuHepMC::CrossSection::Units::pb_PerAtom);
+    auto shard_fatx_pn =
+        workers[i]
+            .source->norm_info(NuHepMC::CrossSection::Units::pb_PerNucleon)
+            .fatx;
+
+    // shards that saw no weight carry no information about the cross section
+    if ((shard_sumweights == 0) || (shard_fatx_pt == 0) ||
+        (shard_fatx_pn == 0)) {
+      continue;
+    }
+    inv_fatx_pt += shard_sumweights / shard_fatx_pt;
+    inv_fatx_pn += shard_sumweights / shard_fatx_pn;
+    sumweights += shard_sumweights;
+  }
+
+  // per-row running estimates are not meaningful across shards, every row
+  // gets the final estimate
+  if (nrows && (sumweights != 0)) {
+    table.col(2) = (sumweights / inv_fatx_pt) / sumweights;
+    table.col(3) = (sumweights / inv_fatx_pn) / sumweights;
+  }
+
+  const auto finish{std::chrono::steady_clock::now()};
+  log_info("EventFrameGen::all() merged {} shards, selected {} from {} "
+           "processed events in {} ms.",
+           workers.size(), n_total_rows, neventsprocessed,
+           std::chrono::duration_cast<std::chrono::milliseconds>(finish - start)
+               .count());
 
-  return {all_column_names, builder, size_t(builder.rows())};
+  return {all_column_names, table, nrows};
 }
 
 #ifdef NUIS_ARROW_ENABLED
@@ -295,8 +969,9 @@ void EventFrameGen::fill_array_builder(
 
   size_t next_col_id = first_col;
 
-  auto const &projs = get_proj_functions<T>()[proj_index](ev);
-  for (size_t i = 0; i < std::min(projs.size(), ncols_to_fill); ++i) {
+  auto [projs, nfilled] =
+      project_into_scratch<T>(scratch, ev, proj_index, ncols_to_fill);
+  for (size_t i = 0; i < nfilled; ++i) {
     BuilderAs<T>(array_builders[next_col_id++]).Append(projs[i]);
   }
 
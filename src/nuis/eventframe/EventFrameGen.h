@@ -1,10 +1,13 @@
 #pragma once
 
 #include "nuis/eventframe/EventFrame.h"
+#include "nuis/eventframe/TypedEventFrame.h"
 #include "nuis/eventframe/column_types.h"
 
 #include "nuis/log.h"
 
+#include "yaml-cpp/yaml.h"
+
 #include <functional>
 #include <numeric>
 
@@ -29,13 +32,28 @@ public:
   template <typename RT>
   using ProjectionsFunc =
       std::function<std::vector<RT>(HepMC3::GenEvent const &)>;
+  // Writes up to ncols values to out and returns the number written, so that
+  // projections do not allocate per event. Columns that are not written are
+  // filled with kMissingDatum.
+  template <typename RT>
+  using ProjectionsIntoFunc =
+      std::function<size_t(HepMC3::GenEvent const &, RT *out, size_t ncols)>;
 
   EventFrameGen(NormalizedEventSourcePtr evs, size_t block_size = 500000);
+  // Builds the event source from an EventSourceFactory configuration node.
+  // When nshards > 1, all() splits the input into nshards entry ranges, each
+  // processed on its own thread by an independently constructed event source.
+  EventFrameGen(YAML::Node const &cfg, size_t nshards,
+                size_t block_size = 500000);
   EventFrameGen filter(FilterFunc filt);
+  // Selects on the EventHeader before events are converted where the source
+  // supports it, see IEventSource::set_prefilter. Rejected entries never reach
+  // filter, projections or limit, but are included in the normalization.
+  EventFrameGen prefilter(EventHeaderFilterFunc filt);
 
   template <typename RT>
-  EventFrameGen add_typed_columns(std::vector<std::string> col_names,
-                                  ProjectionsFunc<RT> proj) {
+  EventFrameGen add_typed_columns_into(std::vector<std::string> col_names,
+                                       ProjectionsIntoFunc<RT> proj) {
 
     auto &projs = get_proj_functions<RT>();
     columns.push_back(
@@ -45,20 +63,34 @@ public:
     return *this;
   }
 
+  template <typename RT>
+  EventFrameGen add_typed_columns(std::vector<std::string> col_names,
+                                  ProjectionsFunc<RT> proj) {
+    return add_typed_columns_into<RT>(
+        col_names, [=](auto const &ev, RT *out, size_t ncols) -> size_t {
+          auto const &vals = proj(ev);
+          size_t nvals = std::min(vals.size(), ncols);
+          std::copy_n(vals.begin(), nvals, out);
+          return nvals;
+        });
+  }
+
   template <typename RT>
   EventFrameGen add_typed_column(std::string col_name,
                                  ProjectionFunc<RT> proj) {
-    add_typed_columns<RT>(
+    return add_typed_columns_into<RT>(
         {
             col_name,
         },
-        [=](auto const &ev) -> std::vector<RT> {
-          return {
-              proj(ev),
-          };
+        [=](auto const &ev, RT *out, size_t) -> size_t {
+          out[0] = proj(ev);
+          return 1;
         });
+  }
 
-    return *this;
+  EventFrameGen add_columns_into(std::vector<std::string> col_names,
+                                 ProjectionsIntoFunc<double> proj) {
+    return add_typed_columns_into<double>(col_names, proj);
   }
 
   EventFrameGen add_columns(std::vector<std::string> col_names,
@@ -100,11 +132,25 @@ public:
 
   EventFrameGen limit(size_t nmax);
   EventFrameGen progress(size_t every = 100000);
+  // Evaluates filters and projections for batches of events on n threads
+  // while this thread reads, rows are kept in input order. Filters and
+  // projections must be safe to call concurrently. Only applies to
+  // first/next/all.
+  EventFrameGen threads(size_t n);
 
   EventFrame first(size_t nchunk = std::numeric_limits<size_t>::max());
   EventFrame next(size_t nchunk = std::numeric_limits<size_t>::max());
   EventFrame all();
 
+  // As first/next/all, but each column keeps the type it was added with.
+  // event.number and process.id are int columns. allTyped does not shard the
+  // input.
+  TypedEventFrame
+  firstTyped(size_t nchunk = std::numeric_limits<size_t>::max());
+  TypedEventFrame
+  nextTyped(size_t nchunk = std::numeric_limits<size_t>::max());
+  TypedEventFrame allTyped();
+
   auto const &get_error_event() { return error_event; }
 
 #ifdef NUIS_ARROW_ENABLED
@@ -117,7 +163,15 @@ public:
 private:
   NormalizedEventSourcePtr source;
 
+  // sharded all() state
+  YAML::Node source_cfg;
+  size_t nshards;
+
+  std::vector<std::pair<size_t, size_t>> shard_entry_ranges();
+  EventFrame all_sharded(std::vector<std::pair<size_t, size_t>> const &ranges);
+
   std::vector<FilterFunc> filters;
+  EventHeaderFilterFunc header_filter;
 
   struct ColumnBlockDefinition {
     std::vector<std::string> column_names;
@@ -128,7 +182,7 @@ private:
   std::vector<ColumnBlockDefinition> columns;
 
   template <typename RT>
-  constexpr std::vector<ProjectionsFunc<RT>> &get_proj_functions() {
+  constexpr std::vector<ProjectionsIntoFunc<RT>> &get_proj_functions() {
     if constexpr (std::is_same_v<RT, bool>) {
       return projectors_bool;
     } else if constexpr (std::is_same_v<RT, int>) {
@@ -146,18 +200,73 @@ private:
     }
   }
 
+  // per-type output buffers for ProjectionsIntoFunc, grown to the widest
+  // column block and then reused for every event, one per thread
+  struct ProjectionScratch {
+    template <typename RT>
+    using scratch_t = Eigen::Array<RT, Eigen::Dynamic, 1>;
+    scratch_t<bool> scratch_bool;
+    scratch_t<int> scratch_int;
+    scratch_t<uint> scratch_uint64_t;
+    scratch_t<int16_t> scratch_int16_t;
+    scratch_t<uint16_t> scratch_uint16_t;
+    scratch_t<float> scratch_float;
+    scratch_t<double> scratch_double;
+
+    template <typename RT> constexpr scratch_t<RT> &get() {
+      if constexpr (std::is_same_v<RT, bool>) {
+        return scratch_bool;
+      } else if constexpr (std::is_same_v<RT, int>) {
+        return scratch_int;
+      } else if constexpr (std::is_same_v<RT, uint>) {
+        return scratch_uint64_t;
+      } else if constexpr (std::is_same_v<RT, int16_t>) {
+        return scratch_int16_t;
+      } else if constexpr (std::is_same_v<RT, uint16_t>) {
+        return scratch_uint16_t;
+      } else if constexpr (std::is_same_v<RT, float>) {
+        return scratch_float;
+      } else if constexpr (std::is_same_v<RT, double>) {
+        return scratch_double;
+      }
+    }
+  };
+  ProjectionScratch scratch;
+
+  // Evaluates projection proj_index into the scratch buffer for its type and
+  // returns the buffer and the number of values written
+  template <typename RT>
+  std::pair<RT const *, size_t>
+  project_into_scratch(ProjectionScratch &scr, HepMC3::GenEvent const &ev,
+                       size_t proj_index, size_t ncols);
+
   template <typename T>
-  size_t fill_row_columns(Eigen::ArrayXdRef row, HepMC3::GenEvent const &ev,
-                          size_t proj_index, size_t first_col,
-                          size_t ncols_to_fill);
-
-  std::vector<ProjectionsFunc<bool>> projectors_bool;
-  std::vector<ProjectionsFunc<int>> projectors_int;
-  std::vector<ProjectionsFunc<uint>> projectors_uint64_t;
-  std::vector<ProjectionsFunc<int16_t>> projectors_int16_t;
-  std::vector<ProjectionsFunc<uint16_t>> projectors_uint16_t;
-  std::vector<ProjectionsFunc<float>> projectors_float;
-  std::vector<ProjectionsFunc<double>> projectors_double;
+  size_t fill_row_columns(ProjectionScratch &scr, Eigen::ArrayXdRef row,
+                          HepMC3::GenEvent const &ev, size_t proj_index,
+                          size_t first_col, size_t ncols_to_fill);
+
+  // fills the projected columns of row, after the default columns
+  void fill_projected_row(ProjectionScratch &scr, Eigen::ArrayXdRef row,
+                          HepMC3::GenEvent const &ev);
+
+  // next() when nthreads > 1
+  EventFrame next_threaded(size_t nchunk);
+
+  // a TypedEventFrame with the generated columns and nrows rows
+  TypedEventFrame make_typed_frame(size_t nrows);
+
+  template <typename T>
+  void fill_typed_columns(TypedEventFrame &frame, size_t row,
+                          HepMC3::GenEvent const &ev, size_t proj_index,
+                          size_t first_col, size_t ncols_to_fill);
+
+  std::vector<ProjectionsIntoFunc<bool>> projectors_bool;
+  std::vector<ProjectionsIntoFunc<int>> projectors_int;
+  std::vector<ProjectionsIntoFunc<uint>> projectors_uint64_t;
+  std::vector<ProjectionsIntoFunc<int16_t>> projectors_int16_t;
+  std::vector<ProjectionsIntoFunc<uint16_t>> projectors_uint16_t;
+  std::vector<ProjectionsIntoFunc<float>> projectors_float;
+  std::vector<ProjectionsIntoFunc<double>> projectors_double;
 
 #ifdef NUIS_ARROW_ENABLED
   template <typename T>
@@ -173,6 +282,7 @@ private:
 
   size_t max_events_to_loop;
   size_t progress_report_every;
+  size_t nthreads;
 
   // first/next state
   std::vector<std::string> all_column_names;
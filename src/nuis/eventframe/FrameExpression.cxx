@@ -0,0 +1,523 @@
+#include "nuis/eventframe/FrameExpression.h"
+
+#include "nuis/eventframe/missing_datum.h"
+
+#include "fmt/core.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+namespace nuis {
+
+struct FrameExpression::Node {
+  enum class Op {
+    Literal,
+    Column,
+    Neg,
+    Not,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Eq,
+    Ne,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    And,
+    Or,
+    Abs,
+    Sqrt,
+    Exp,
+    Log,
+    Log10,
+    Sin,
+    Cos,
+    Tan,
+    Acos,
+    Asin,
+    Atan,
+    Atan2,
+    Pow,
+    Min,
+    Max,
+    Where
+  };
+
+  Op op;
+  double value;
+  // index into FrameExpression::columns
+  size_t column;
+  // index of the scratch buffer that this node is evaluated into
+  size_t id;
+  std::vector<std::unique_ptr<Node const>> args;
+};
+
+namespace {
+
+using Node = FrameExpression::Node;
+using Op = Node::Op;
+using NodePtr = std::unique_ptr<Node const>;
+
+// the number of rows evaluated at a time, so that intermediate results stay
+// in cache
+constexpr Eigen::Index const expression_block_size = 4096;
+
+std::map<std::string, std::pair<Op, size_t>> const expression_functions = {
+    {"abs", {Op::Abs, 1}},     {"sqrt", {Op::Sqrt, 1}},
+    {"exp", {Op::Exp, 1}},     {"log", {Op::Log, 1}},
+    {"log10", {Op::Log10, 1}}, {"sin", {Op::Sin, 1}},
+    {"cos", {Op::Cos, 1}},     {"tan", {Op::Tan, 1}},
+    {"acos", {Op::Acos, 1}},   {"asin", {Op::Asin, 1}},
+    {"atan", {Op::Atan, 1}},   {"atan2", {Op::Atan2, 2}},
+    {"pow", {Op::Pow, 2}},     {"min", {Op::Min, 2}},
+    {"max", {Op::Max, 2}},     {"where", {Op::Where, 3}},
+};
+
+struct Token {
+  enum class Type { Number, Name, Symbol, End };
+  Type type;
+  std::string text;
+  double number;
+  size_t pos;
+};
+
+std::vector<Token> Tokenize(std::string const &expr) {
+  std::vector<Token> tokens;
+  size_t i = 0;
+  while (i < expr.size()) {
+    char c = expr[i];
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      i++;
+    } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+               ((c == '.') && (i + 1 < expr.size()) &&
+                std::isdigit(static_cast<unsigned char>(expr[i + 1])))) {
+      char *end = nullptr;
+      double num = std::strtod(expr.c_str() + i, &end);
+      size_t len = end - (expr.c_str() + i);
+      tokens.push_back({Token::Type::Number, expr.substr(i, len), num, i});
+      i += len;
+    } else if (std::isalpha(static_cast<unsigned char>(c)) || (c == '_')) {
+      size_t len = 1;
+      while ((i + len < expr.size()) &&
+             (std::isalnum(static_cast<unsigned char>(expr[i + len])) ||
+              (expr[i + len] == '_') || (expr[i + len] == '.'))) {
+        len++;
+      }
+      tokens.push_back({Token::Type::Name, expr.substr(i, len), 0, i});
+      i += len;
+    } else if (c == '`') {
+      auto close = expr.find('`', i + 1);
+      if (close == std::string::npos) {
+        throw InvalidFrameExpression()
+            << "Unterminated quoted column name at position " << i
+            << " in expression: " << expr;
+      }
+      tokens.push_back(
+          {Token::Type::Name, expr.substr(i + 1, close - i - 1), 0, i});
+      i = close + 1;
+    } else {
+      std::string two = expr.substr(i, 2);
+      if ((two == "==") || (two == "!=") || (two == "<=") || (two == ">=") ||
+          (two == "&&") || (two == "||")) {
+        tokens.push_back({Token::Type::Symbol, two, 0, i});
+        i += 2;
+      } else if (std::string("+-*/<>!&|(),").find(c) != std::string::npos) {
+        tokens.push_back({Token::Type::Symbol, std::string(1, c), 0, i});
+        i++;
+      } else {
+        throw InvalidFrameExpression()
+            << "Unexpected character '" << c << "' at position " << i
+            << " in expression: " << expr;
+      }
+    }
+  }
+  tokens.push_back({Token::Type::End, "", 0, expr.size()});
+  return tokens;
+}
+
+// Recursive descent parser, from lowest to highest precedence:
+// | , & , comparisons , + - , * / , unary - ! , primary
+class Parser {
+  std::string const &expr;
+  std::vector<Token> tokens;
+  size_t tok;
+  std::vector<std::string> &columns;
+  size_t nnodes;
+
+  std::unique_ptr<Node> node(Op op, std::vector<NodePtr> args = {}) {
+    auto n = std::make_unique<Node>();
+    n->op = op;
+    n->value = 0;
+    n->column = 0;
+    n->id = nnodes++;
+    n->args = std::move(args);
+    return n;
+  }
+
+  Token const &peek() const { return tokens[tok]; }
+  bool accept(std::string const &sym) {
+    if ((peek().type == Token::Type::Symbol) && (peek().text == sym)) {
+      tok++;
+      return true;
+    }
+    return false;
+  }
+  void expect(std::string const &sym) {
+    if (!accept(sym)) {
+      fail(fmt::format("expected '{}'", sym));
+    }
+  }
+  [[noreturn]] void fail(std::string const &what) const {
+    throw InvalidFrameExpression()
+        << what << " at position " << peek().pos << " in expression: " << expr;
+  }
+
+  NodePtr binary(Op op, NodePtr lhs, NodePtr rhs) {
+    std::vector<NodePtr> args;
+    args.push_back(std::move(lhs));
+    args.push_back(std::move(rhs));
+    return node(op, std::move(args));
+  }
+
+  NodePtr parse_or() {
+    auto lhs = parse_and();
+    while (accept("|") || accept("||")) {
+      lhs = binary(Op::Or, std::move(lhs), parse_and());
+    }
+    return lhs;
+  }
+
+  NodePtr parse_and() {
+    auto lhs = parse_comparison();
+    while (accept("&") || accept("&&")) {
+      lhs = binary(Op::And, std::move(lhs), parse_comparison());
+    }
+    return lhs;
+  }
+
+  NodePtr parse_comparison() {
+    auto lhs = parse_sum();
+    static std::vector<std::pair<std::string, Op>> const comparisons = {
+        {"==", Op::Eq}, {"!=", Op::Ne}, {"<=", Op::Le},
+        {">=", Op::Ge}, {"<", Op::Lt},  {">", Op::Gt}};
+    for (auto const &[sym, op] : comparisons) {
+      if (accept(sym)) {
+        return binary(op, std::move(lhs), parse_sum());
+      }
+    }
+    return lhs;
+  }
+
+  NodePtr parse_sum() {
+    auto lhs = parse_product();
+    while (true) {
+      if (accept("+")) {
+        lhs = binary(Op::Add, std::move(lhs), parse_product());
+      } else if (accept("-")) {
+        lhs = binary(Op::Sub, std::move(lhs), parse_product());
+      } else {
+        return lhs;
+      }
+    }
+  }
+
+  NodePtr parse_product() {
+    auto lhs = parse_unary();
+    while (true) {
+      if (accept("*")) {
+        lhs = binary(Op::Mul, std::move(lhs), parse_unary());
+      } else if (accept("/")) {
+        lhs = binary(Op::Div, std::move(lhs), parse_unary());
+      } else {
+        return lhs;
+      }
+    }
+  }
+
+  NodePtr parse_unary() {
+    if (accept("-")) {
+      std::vector<NodePtr> args;
+      args.push_back(parse_unary());
+      return node(Op::Neg, std::move(args));
+    } else if (accept("!")) {
+      std::vector<NodePtr> args;
+      args.push_back(parse_unary());
+      return node(Op::Not, std::move(args));
+    } else if (accept("+")) {
+      return parse_unary();
+    }
+    return parse_primary();
+  }
+
+  NodePtr parse_primary() {
+    auto const &t = peek();
+    if (t.type == Token::Type::Number) {
+      tok++;
+      auto n = node(Op::Literal);
+      n->value = t.number;
+      return n;
+    }
+
+    if (t.type == Token::Type::Name) {
+      std::string name = t.text;
+      tok++;
+
+      if (accept("(")) {
+        auto fn = expression_functions.find(name);
+        if (fn == expression_functions.end()) {
+          fail(fmt::format("unknown function '{}'", name));
+        }
+        std::vector<NodePtr> args;
+        if (!accept(")")) {
+          do {
+            args.push_back(parse_or());
+          } while (accept(","));
+          expect(")");
+        }
+        if (args.size() != fn->second.second) {
+          fail(fmt::format("function '{}' takes {} arguments, but was passed "
+                           "{}",
+                           name, fn->second.second, args.size()));
+        }
+        return node(fn->second.first, std::move(args));
+      }
+
+      auto n = node(Op::Column);
+      auto pos = std::find(columns.begin(), columns.end(), name);
+      n->column = pos - columns.begin();
+      if (pos == columns.end()) {
+        columns.push_back(name);
+      }
+      return n;
+    }
+
+    if (accept("(")) {
+      auto n = parse_or();
+      expect(")");
+      return n;
+    }
+
+    fail(t.type == Token::Type::End
+             ? std::string("unexpected end of expression")
+             : fmt::format("unexpected '{}'", t.text));
+  }
+
+public:
+  Parser(std::string const &e, std::vector<std::string> &cols)
+      : expr{e}, tokens{Tokenize(e)}, tok{0}, columns{cols}, nnodes{0} {}
+
+  NodePtr parse() {
+    auto n = parse_or();
+    if (peek().type != Token::Type::End) {
+      fail(fmt::format("unexpected '{}'", peek().text));
+    }
+    return n;
+  }
+
+  size_t nodes() const { return nnodes; }
+};
+
+// a column of a block of rows, either of the table or of a scratch buffer
+using BlockView = Eigen::Map<Eigen::ArrayXd const>;
+
+struct BlockContext {
+  Eigen::ArrayXXd const &table;
+  std::vector<EventFrame::column_t> const &cids;
+  // one buffer per node, allocated once and reused for every block
+  std::vector<Eigen::ArrayXd> &scratch;
+  Eigen::Index first_row;
+  Eigen::Index nrows;
+};
+
+BlockView Evaluate(Node const &n, BlockContext const &ctx) {
+  if (n.op == Op::Column) {
+    return BlockView(ctx.table.col(ctx.cids[n.column]).data() + ctx.first_row,
+                     ctx.nrows);
+  }
+
+  auto arg = [&](size_t i) { return Evaluate(*n.args[i], ctx); };
+  auto res = ctx.scratch[n.id].head(ctx.nrows);
+
+  switch (n.op) {
+  case Op::Literal:
+    res.setConstant(n.value);
+    break;
+  case Op::Column:
+    break;
+  case Op::Neg:
+    res = -arg(0);
+    break;
+  case Op::Not:
+    res = (arg(0) == 0).cast<double>();
+    break;
+  case Op::Add:
+    res = arg(0) + arg(1);
+    break;
+  case Op::Sub:
+    res = arg(0) - arg(1);
+    break;
+  case Op::Mul:
+    res = arg(0) * arg(1);
+    break;
+  case Op::Div:
+    res = arg(0) / arg(1);
+    break;
+  case Op::Eq:
+    res = (arg(0) == arg(1)).cast<double>();
+    break;
+  case Op::Ne:
+    res = (arg(0) != arg(1)).cast<double>();
+    break;
+  case Op::Lt:
+    res = (arg(0) < arg(1)).cast<double>();
+    break;
+  case Op::Le:
+    res = (arg(0) <= arg(1)).cast<double>();
+    break;
+  case Op::Gt:
+    res = (arg(0) > arg(1)).cast<double>();
+    break;
+  case Op::Ge:
+    res = (arg(0) >= arg(1)).cast<double>();
+    break;
+  case Op::And:
+    res = ((arg(0) != 0) && (arg(1) != 0)).cast<double>();
+    break;
+  case Op::Or:
+    res = ((arg(0) != 0) || (arg(1) != 0)).cast<double>();
+    break;
+  case Op::Abs:
+    res = arg(0).abs();
+    break;
+  case Op::Sqrt:
+    res = arg(0).sqrt();
+    break;
+  case Op::Exp:
+    res = arg(0).exp();
+    break;
+  case Op::Log:
+    res = arg(0).log();
+    break;
+  case Op::Log10:
+    res = arg(0).log10();
+    break;
+  case Op::Sin:
+    res = arg(0).sin();
+    break;
+  case Op::Cos:
+    res = arg(0).cos();
+    break;
+  case Op::Tan:
+    res = arg(0).tan();
+    break;
+  case Op::Acos:
+    res = arg(0).acos();
+    break;
+  case Op::Asin:
+    res = arg(0).asin();
+    break;
+  case Op::Atan:
+    res = arg(0).atan();
+    break;
+  case Op::Atan2:
+    res = arg(0).binaryExpr(
+        arg(1), [](double y, double x) { return std::atan2(y, x); });
+    break;
+  case Op::Pow:
+    res = arg(0).pow(arg(1));
+    break;
+  case Op::Min:
+    res = arg(0).min(arg(1));
+    break;
+  case Op::Max:
+    res = arg(0).max(arg(1));
+    break;
+  case Op::Where:
+    res = (arg(0) != 0).select(arg(1), arg(2));
+    break;
+  }
+  return BlockView(ctx.scratch[n.id].data(), ctx.nrows);
+}
+
+} // namespace
+
+FrameExpression::FrameExpression(std::string const &e) : expr{e} {
+  Parser p(expr, columns);
+  root = p.parse();
+  nnodes = p.nodes();
+}
+
+Eigen::ArrayXd FrameExpression::evaluate(EventFrame const &ef) const {
+  std::vector<EventFrame::column_t> cids;
+  for (auto const &cn : columns) {
+    cids.push_back(ef.require_column_index(cn));
+  }
+
+  Eigen::Index nrows = ef.table.rows();
+  Eigen::ArrayXd out(nrows);
+  std::vector<Eigen::ArrayXd> scratch(
+      nnodes, Eigen::ArrayXd(std::min(expression_block_size, nrows)));
+
+  BlockContext ctx{ef.table, cids, scratch, 0, 0};
+  for (; ctx.first_row < nrows; ctx.first_row += expression_block_size) {
+    ctx.nrows = std::min(expression_block_size, nrows - ctx.first_row);
+    auto out_block = out.segment(ctx.first_row, ctx.nrows);
+    out_block = Evaluate(*root, ctx);
+
+    // missing inputs give missing outputs
+    for (auto cid : cids) {
+      out_block = (ef.table.col(cid).segment(ctx.first_row, ctx.nrows) ==
+                   kMissingDatum<double>)
+                      .select(kMissingDatum<double>, out_block);
+    }
+  }
+
+  return out;
+}
+
+void DeriveColumns(
+    EventFrame &ef,
+    std::vector<std::pair<std::string, std::string>> const &name_exprs) {
+
+  // parse and check every expression before touching the frame, so that a
+  // bad expression leaves it unchanged
+  std::vector<FrameExpression> exprs;
+  auto known_columns = ef.column_names;
+  for (auto const &[name, expr] : name_exprs) {
+    if (std::find(known_columns.begin(), known_columns.end(), name) !=
+        known_columns.end()) {
+      throw InvalidFrameColumnName() << fmt::format(
+          "DeriveColumns cannot add column \"{}\", it already exists.", name);
+    }
+    exprs.emplace_back(expr);
+    for (auto const &cn : exprs.back().column_names()) {
+      if (std::find(known_columns.begin(), known_columns.end(), cn) ==
+          known_columns.end()) {
+        throw InvalidFrameColumnName() << fmt::format(
+            "Expression \"{}\" for column \"{}\" reads column \"{}\", but no "
+            "such column exists.",
+            expr, name, cn);
+      }
+    }
+    known_columns.push_back(name);
+  }
+
+  auto first_new_col = ef.table.cols();
+  ef.table.conservativeResize(Eigen::NoChange,
+                              first_new_col + name_exprs.size());
+  for (size_t i = 0; i < exprs.size(); ++i) {
+    ef.table.col(first_new_col + i) = exprs[i].evaluate(ef);
+    ef.column_names.push_back(name_exprs[i].first);
+  }
+}
+
+void DeriveColumn(EventFrame &ef, std::string const &name,
+                  std::string const &expr) {
+  DeriveColumns(ef, {{name, expr}});
+}
+
+} // namespace nuis
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "nuis/eventframe/EventFrame.h"
+
+#include "nuis/except.h"
+
+#include "Eigen/Dense"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nuis {
+
+DECLARE_NUISANCE_EXCEPT(InvalidFrameExpression);
+
+/// An arithmetic expression over the columns of an EventFrame, evaluated
+/// with Eigen array operations over blocks of rows rather than per event,
+/// e.g. "enu - emu", "pz / sqrt(px*px + py*py + pz*pz)" or
+/// "(nmu == 1) & (npi == 0)".
+///
+/// Supports + - * /, comparisons, & | ! (true is 1, false is 0), numeric
+/// literals and the functions abs, sqrt, exp, log, log10, sin, cos, tan,
+/// acos, asin, atan, atan2, pow, min, max and where(cond, a, b). Column
+/// names may contain dots, other names can be quoted with backticks. Rows
+/// where any referenced column is kMissingDatum evaluate to kMissingDatum.
+class FrameExpression {
+public:
+  struct Node;
+
+  // throws InvalidFrameExpression if expr cannot be parsed
+  explicit FrameExpression(std::string const &expr);
+
+  // throws InvalidFrameColumnName if a referenced column is not in ef
+  Eigen::ArrayXd evaluate(EventFrame const &ef) const;
+
+  std::string const &expression() const { return expr; }
+  // the names of the columns that the expression reads
+  std::vector<std::string> const &column_names() const { return columns; }
+
+private:
+  std::string expr;
+  std::vector<std::string> columns;
+  std::shared_ptr<Node const> root;
+  // each node evaluates into its own scratch buffer
+  size_t nnodes;
+};
+
+// Appends a column called name to ef holding the values of expr
+void DeriveColumn(EventFrame &ef, std::string const &name,
+                  std::string const &expr);
+// Appends several {name, expr} columns with a single resize of the table.
+// Expressions are evaluated in order and may refer to earlier new columns.
+void DeriveColumns(
+    EventFrame &ef,
+    std::vector<std::pair<std::string, std::string>> const &name_exprs);
+
+} // namespace nuis
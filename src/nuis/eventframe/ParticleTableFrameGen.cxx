@@ -0,0 +1,241 @@
+#include "nuis/eventframe/ParticleTableFrameGen.h"
+
+#include "nuis/eventinput/EventSourceFactory.h"
+#include "nuis/eventinput/IEventSourceWrapper.h"
+
+#include "NuHepMC/EventUtils.hxx"
+#include "NuHepMC/FATXUtils.hxx"
+#include "NuHepMC/UnitsUtils.hxx"
+
+#include "HepMC3/GenEvent.h"
+
+#include "nuis/log.txx"
+
+#include <cmath>
+
+DECLARE_NUISANCE_EXCEPT(InvalidParticleTableSource);
+
+static std::vector<std::string> const default_ptfg_columns{
+    "event.number", "weight.cv", "fatx_per_sumw.pb_per_target.estimate",
+    "fatx_per_sumw.pb_per_nucleon.estimate", "process.id"};
+
+namespace nuis {
+
+IParticleTableSourcePtr MakeParticleTableSource(YAML::Node const &cfg) {
+  auto [gri, evs] = EventSourceFactory().make_unnormalized(YAML::Clone(cfg));
+  if (!evs) {
+    throw InvalidParticleTableSource()
+        << "EventSourceFactory failed to build an event source from: "
+        << YAML::Dump(cfg);
+  }
+
+  auto tbls = std::dynamic_pointer_cast<IParticleTableSource>(evs);
+  if (!tbls) {
+    if (auto wrapper = std::dynamic_pointer_cast<IEventSourceWrapper>(evs)) {
+      tbls = std::dynamic_pointer_cast<IParticleTableSource>(wrapper->unwrap());
+      if (tbls) {
+        log_warn("ParticleTableFrameGen reads the underlying event source "
+                 "directly, event source wrappers such as entry_range and "
+                 "subsample are not applied.");
+      }
+    }
+  }
+
+  if (!tbls) {
+    throw InvalidParticleTableSource()
+        << "The event source built from: " << YAML::Dump(cfg)
+        << " cannot produce ParticleTables, use EventFrameGen instead.";
+  }
+  return tbls;
+}
+
+ParticleTableFrameGen::ParticleTableFrameGen(IParticleTableSourcePtr tbls,
+                                             size_t block_size)
+    : source(tbls), chunk_size{block_size},
+      table_size{std::min(block_size, size_t(10000))},
+      max_events_to_loop{std::numeric_limits<size_t>::max()}, tbl_ev{0} {}
+
+ParticleTableFrameGen::ParticleTableFrameGen(YAML::Node const &cfg,
+                                             size_t block_size)
+    : ParticleTableFrameGen(MakeParticleTableSource(cfg), block_size) {}
+
+ParticleTableFrameGen ParticleTableFrameGen::filter(FilterFunc filt) {
+  filters.push_back(filt);
+  return *this;
+}
+
+ParticleTableFrameGen
+ParticleTableFrameGen::prefilter(EventHeaderFilterFunc filt) {
+  if (header_filter) {
+    header_filter = [=, prev = header_filter](EventHeader const &hdr) {
+      return prev(hdr) && filt(hdr);
+    };
+  } else {
+    header_filter = filt;
+  }
+  auto evs = std::dynamic_pointer_cast<IEventSource>(source);
+  if (!evs || !evs->set_prefilter(header_filter)) {
+    throw InvalidParticleTableSource()
+        << "ParticleTableFrameGen::prefilter() the table source cannot apply "
+           "the prefilter.";
+  }
+  return *this;
+}
+
+ParticleTableFrameGen ParticleTableFrameGen::add_column(std::string col_name,
+                                                        ProjectionFunc proj) {
+  columns.push_back(ColumnDefinition{col_name, proj, nullptr});
+  return *this;
+}
+
+ParticleTableFrameGen
+ParticleTableFrameGen::add_bulk_column(std::string col_name,
+                                       BulkProjectionFunc proj) {
+  columns.push_back(ColumnDefinition{col_name, nullptr, proj});
+  return *this;
+}
+
+ParticleTableFrameGen ParticleTableFrameGen::limit(size_t nmax) {
+  max_events_to_loop = nmax;
+  return *this;
+}
+
+void ParticleTableFrameGen::project_table() {
+  tbl_ev = 0;
+  // bulk projections see the whole table, including prefiltered events
+  bulk_cols.resize(tbl.nevents(), columns.size());
+  for (size_t ci = 0; ci < columns.size(); ++ci) {
+    if (columns[ci].bulk_proj) {
+      columns[ci].bulk_proj(tbl, bulk_cols.col(ci));
+    }
+  }
+}
+
+bool ParticleTableFrameGen::next_table() {
+  if (!source->next_table(tbl, table_size)) {
+    return false;
+  }
+  project_table();
+  return true;
+}
+
+double ParticleTableFrameGen::process(size_t ev) {
+  norm_stub->weights()[0] = tbl.weight[ev];
+  if (!std::isnan(tbl.total_xs[ev])) {
+    NuHepMC::EC2::SetTotalCrossSection(*norm_stub, tbl.total_xs[ev]);
+  }
+  return xs_acc->process(*norm_stub);
+}
+
+EventFrame ParticleTableFrameGen::first(size_t nchunk) {
+  all_column_names = default_ptfg_columns;
+  for (auto const &col : columns) {
+    all_column_names.push_back(col.name);
+  }
+
+  n_total_rows = 0;
+  neventsprocessed = 0;
+
+  if (!source->first_table(tbl, table_size)) {
+    return {all_column_names, Eigen::ArrayXXd(0, all_column_names.size()), 0};
+  }
+
+  auto gri = source->run_info();
+  xs_acc = NuHepMC::FATX::MakeAccumulator(gri);
+  // the accumulator only needs the weights and the E.C.2 total cross section,
+  // so one stub event stands in for every table event
+  norm_stub = MakePrefilteredStub(gri, 0);
+
+  project_table();
+
+  return next(nchunk);
+}
+
+EventFrame ParticleTableFrameGen::next(size_t nchunk) {
+  if (nchunk == std::numeric_limits<size_t>::max()) {
+    nchunk = chunk_size;
+  }
+
+  if (!xs_acc || (neventsprocessed >= max_events_to_loop)) {
+    return {all_column_names, Eigen::ArrayXXd(0, all_column_names.size()), 0};
+  }
+
+  Eigen::ArrayXXd chunk(nchunk, all_column_names.size());
+  size_t chunk_row = 0;
+
+  while ((chunk_row < nchunk) && (neventsprocessed < max_events_to_loop)) {
+    if ((tbl_ev >= tbl.nevents()) && !next_table()) {
+      break;
+    }
+
+    size_t ev = tbl_ev++;
+    double cvw = process(ev);
+
+    // prefiltered events only contribute to the normalization
+    if (tbl.prefiltered(ev)) {
+      continue;
+    }
+
+    neventsprocessed++;
+
+    bool cut = false;
+    for (auto &filt : filters) {
+      if (!filt(tbl, ev)) {
+        cut = true;
+        break;
+      }
+    }
+    if (cut) {
+      continue;
+    }
+
+    chunk(chunk_row, 0) = tbl.event_number[ev];
+    chunk(chunk_row, 1) = cvw;
+    chunk(chunk_row, 2) =
+        xs_acc->fatx(NuHepMC::CrossSection::Units::pb_PerAtom) /
+        xs_acc->sumweights();
+    chunk(chunk_row, 3) =
+        xs_acc->fatx(NuHepMC::CrossSection::Units::pb_PerNucleon) /
+        xs_acc->sumweights();
+    chunk(chunk_row, 4) = tbl.process_id[ev];
+
+    size_t col_id = default_ptfg_columns.size();
+    for (size_t ci = 0; ci < columns.size(); ++ci) {
+      chunk(chunk_row, col_id++) = columns[ci].proj ? columns[ci].proj(tbl, ev)
+                                                    : bulk_cols(ev, ci);
+    }
+
+    n_total_rows++;
+    chunk_row++;
+  }
+
+  if (chunk_row) {
+    // reset the last fatx entries to be the final best estimate, see
+    // EventFrameGen::next
+    chunk(chunk_row - 1, 2) =
+        xs_acc->fatx(NuHepMC::CrossSection::Units::pb_PerAtom) /
+        xs_acc->sumweights();
+    chunk(chunk_row - 1, 3) =
+        xs_acc->fatx(NuHepMC::CrossSection::Units::pb_PerNucleon) /
+        xs_acc->sumweights();
+  }
+
+  log_info("ParticleTableFrameGen::next() n_total_rows: {} neventsprocessed: "
+           "{} chunk_row: {}",
+           n_total_rows, neventsprocessed, chunk_row);
+
+  return {all_column_names, chunk.topRows(chunk_row), chunk_row};
+}
+
+EventFrame ParticleTableFrameGen::all() {
+  std::vector<EventFrame> chunks;
+  for (auto chunk = first(); chunk.table.rows(); chunk = next()) {
+    chunks.push_back(std::move(chunk));
+  }
+  if (!chunks.size()) {
+    return {all_column_names, Eigen::ArrayXXd(0, all_column_names.size()), 0};
+  }
+  return EventFrame::Concatenate(chunks);
+}
+
+} // namespace nuis
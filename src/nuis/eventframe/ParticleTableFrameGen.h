@@ -0,0 +1,91 @@
+#pragma once
+
+#include "nuis/eventframe/EventFrame.h"
+
+#include "nuis/eventinput/ParticleTable.h"
+
+#include "nuis/log.h"
+
+#include "yaml-cpp/yaml.h"
+
+#include <functional>
+
+namespace NuHepMC::FATX {
+class Accumulator;
+} // namespace NuHepMC::FATX
+
+namespace nuis {
+
+/// Builds EventFrames straight from the ParticleTables of an
+/// IParticleTableSource, for flat-kinematics analyses that do not need a
+/// HepMC3::GenEvent per event. Columns are the same defaults as
+/// EventFrameGen followed by any added columns.
+class ParticleTableFrameGen : public nuis_named_log("EventFrame") {
+
+public:
+  using FilterFunc = std::function<int(ParticleTable const &, size_t)>;
+  using ProjectionFunc = std::function<double(ParticleTable const &, size_t)>;
+  // fills one value per event of the table at once
+  using BulkProjectionFunc =
+      std::function<void(ParticleTable const &, Eigen::Ref<Eigen::ArrayXd>)>;
+
+  ParticleTableFrameGen(IParticleTableSourcePtr tbls,
+                        size_t block_size = 500000);
+  // Builds the table source from an EventSourceFactory configuration node,
+  // throws if the resulting source cannot produce ParticleTables.
+  ParticleTableFrameGen(YAML::Node const &cfg, size_t block_size = 500000);
+
+  ParticleTableFrameGen filter(FilterFunc filt);
+  // Passed to the table source, rejected events are included in the
+  // normalization only, see IEventSource::set_prefilter.
+  ParticleTableFrameGen prefilter(EventHeaderFilterFunc filt);
+  ParticleTableFrameGen add_column(std::string col_name, ProjectionFunc proj);
+  ParticleTableFrameGen add_bulk_column(std::string col_name,
+                                        BulkProjectionFunc proj);
+
+  ParticleTableFrameGen limit(size_t nmax);
+
+  EventFrame first(size_t nchunk = std::numeric_limits<size_t>::max());
+  EventFrame next(size_t nchunk = std::numeric_limits<size_t>::max());
+  EventFrame all();
+
+private:
+  IParticleTableSourcePtr source;
+
+  std::vector<FilterFunc> filters;
+  EventHeaderFilterFunc header_filter;
+
+  struct ColumnDefinition {
+    std::string name;
+    ProjectionFunc proj;
+    BulkProjectionFunc bulk_proj;
+  };
+  std::vector<ColumnDefinition> columns;
+
+  // evaluates the bulk columns for tbl and rewinds tbl_ev
+  void project_table();
+  // reads the next table into tbl, true if it has any events
+  bool next_table();
+  // the CV weight of event ev of the current table, every table event must be
+  // passed through here, in order, whether it is selected or not
+  double process(size_t ev);
+
+  size_t chunk_size;
+  size_t table_size;
+  size_t max_events_to_loop;
+
+  // first/next state
+  std::vector<std::string> all_column_names;
+  size_t n_total_rows;
+  size_t neventsprocessed;
+
+  ParticleTable tbl;
+  // the current table event and the bulk columns evaluated for tbl
+  size_t tbl_ev;
+  Eigen::ArrayXXd bulk_cols;
+
+  std::shared_ptr<NuHepMC::FATX::Accumulator> xs_acc;
+  std::shared_ptr<HepMC3::GenEvent> norm_stub;
+};
+
+} // namespace nuis
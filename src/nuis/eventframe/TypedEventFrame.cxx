@@ -0,0 +1,143 @@
+#include "nuis/eventframe/TypedEventFrame.h"
+
+#include "fmt/core.h"
+#include "fmt/ranges.h"
+
+#define COLUMN_TYPE_ITER                                                       \
+  X(bool)                                                                      \
+  X(int)                                                                       \
+  X(uint)                                                                      \
+  X(int16_t)                                                                   \
+  X(uint16_t)                                                                  \
+  X(float)                                                                     \
+  X(double)
+
+namespace nuis {
+
+TypedEventFrame::column_t
+TypedEventFrame::find_column_index(std::string const &cn) const {
+  auto pos = std::find(column_names.begin(), column_names.end(), cn);
+  if (pos == column_names.end()) {
+    return TypedEventFrame::npos;
+  }
+  return pos - column_names.begin();
+}
+
+TypedEventFrame::column_t
+TypedEventFrame::require_column_index(std::string const &cn) const {
+  auto col = find_column_index(cn);
+  if (col == TypedEventFrame::npos) {
+    throw InvalidFrameColumnName()
+        << fmt::format("require_column_index(column=\"{}\"), but no such "
+                       "column exists. Valid columns: {}",
+                       cn, column_names);
+  }
+  return col;
+}
+
+Eigen::ArrayXd TypedEventFrame::col_as_double(column_t cid) const {
+  if (cid >= column_typenums.size()) {
+    throw InvalidFrameColumnName() << "TypedEventFrame has no column " << cid;
+  }
+  switch (column_typenums[cid]) {
+#define X(t)                                                                   \
+  case column_type<t>::id:                                                     \
+    return col<t>(cid).template cast<double>();
+
+    COLUMN_TYPE_ITER
+#undef X
+  }
+  throw InvalidFrameColumnType()
+      << "TypedEventFrame column " << column_names[cid]
+      << " has unhandled type number " << column_typenums[cid];
+}
+
+Eigen::ArrayXd TypedEventFrame::col_as_double(std::string const &cn) const {
+  return col_as_double(require_column_index(cn));
+}
+
+EventFrame TypedEventFrame::as_EventFrame() const {
+  Eigen::ArrayXXd table(num_rows, column_names.size());
+  for (column_t ci = 0; ci < column_names.size(); ++ci) {
+    table.col(ci) = col_as_double(ci);
+  }
+  return {column_names, table, num_rows};
+}
+
+void TypedEventFrame::conservativeResize(size_t rows) {
+#define X(t)                                                                   \
+  for (auto &c : cols_##t) {                                                   \
+    c.conservativeResize(rows);                                                \
+  }
+
+  COLUMN_TYPE_ITER
+#undef X
+  num_rows = rows;
+}
+
+TypedEventFrame TypedEventFrame::topRows(size_t rows) const {
+  rows = std::min(rows, num_rows);
+  TypedEventFrame out;
+  out.column_names = column_names;
+  out.column_typenums = column_typenums;
+  out.column_storage_index = column_storage_index;
+  out.num_rows = rows;
+#define X(t)                                                                   \
+  out.cols_##t.reserve(cols_##t.size());                                       \
+  for (auto const &c : cols_##t) {                                             \
+    out.cols_##t.emplace_back(c.head(rows));                                   \
+  }
+
+  COLUMN_TYPE_ITER
+#undef X
+  return out;
+}
+
+TypedEventFrame
+TypedEventFrame::Concatenate(std::vector<TypedEventFrame> const &frames) {
+  if (!frames.size()) {
+    return TypedEventFrame();
+  }
+
+  size_t nrows = 0;
+  for (auto const &f : frames) {
+    if (f.column_typenums != frames.front().column_typenums) {
+      throw InvalidFrameColumnType()
+          << "TypedEventFrame::Concatenate passed frames with different "
+             "column types.";
+    }
+    nrows += f.num_rows;
+  }
+
+  TypedEventFrame out = frames.front();
+  out.conservativeResize(nrows);
+
+  size_t first_row = frames.front().num_rows;
+  for (size_t fi = 1; fi < frames.size(); ++fi) {
+    auto const &f = frames[fi];
+#define X(t)                                                                   \
+  for (size_t i = 0; i < f.cols_##t.size(); ++i) {                             \
+    out.cols_##t[i].segment(first_row, f.num_rows) = f.cols_##t[i];            \
+  }
+
+    COLUMN_TYPE_ITER
+#undef X
+    first_row += f.num_rows;
+  }
+  return out;
+}
+
+size_t TypedEventFrame::data_size() const {
+  size_t bytes = 0;
+#define X(t) bytes += cols_##t.size() * num_rows * sizeof(t);
+
+  COLUMN_TYPE_ITER
+#undef X
+  return bytes;
+}
+
+std::ostream &operator<<(std::ostream &os, nuis::TypedEventFrame const &f) {
+  return os << nuis::EventFramePrinter(f.as_EventFrame());
+}
+
+} // namespace nuis
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "nuis/eventframe/EventFrame.h"
+#include "nuis/eventframe/column_types.h"
+
+#include "nuis/except.h"
+
+#include "Eigen/Dense"
+
+#include <string>
+#include <vector>
+
+namespace nuis {
+
+DECLARE_NUISANCE_EXCEPT(InvalidFrameColumnType);
+
+/// A columnar EventFrame where each column keeps the type it was declared
+/// with in EventFrameGen, so that flags and integer IDs do not each take a
+/// double. Use col<T>() for typed access and as_EventFrame() or
+/// col_as_double() for the all-double view.
+struct TypedEventFrame {
+  template <typename T>
+  using column_array_t = Eigen::Array<T, Eigen::Dynamic, 1>;
+
+  using column_t = EventFrame::column_t;
+  constexpr static column_t const npos = EventFrame::npos;
+
+  std::vector<std::string> column_names;
+  // the column_type<T>::id of each column
+  std::vector<int> column_typenums;
+  size_t num_rows;
+
+  TypedEventFrame() : num_rows{0} {}
+
+  // Appends a column of num_rows default-initialized entries
+  template <typename T> column_array_t<T> &add_column(std::string const &name) {
+    column_names.push_back(name);
+    column_typenums.push_back(column_type<T>::id);
+    auto &storage = get_storage<T>();
+    column_storage_index.push_back(storage.size());
+    storage.emplace_back(num_rows);
+    return storage.back();
+  }
+
+  column_t find_column_index(std::string const &name) const;
+  // as find but throws if named column doesn't exist
+  column_t require_column_index(std::string const &name) const;
+
+  // throws InvalidFrameColumnType if column cid is not of type T
+  template <typename T> column_array_t<T> &col(column_t cid) {
+    require_column_type<T>(cid);
+    return get_storage<T>()[column_storage_index[cid]];
+  }
+  template <typename T> column_array_t<T> const &col(column_t cid) const {
+    require_column_type<T>(cid);
+    return get_storage<T>()[column_storage_index[cid]];
+  }
+  template <typename T> column_array_t<T> &col(std::string const &cn) {
+    return col<T>(require_column_index(cn));
+  }
+  template <typename T>
+  column_array_t<T> const &col(std::string const &cn) const {
+    return col<T>(require_column_index(cn));
+  }
+
+  // A copy of the named column converted to double
+  Eigen::ArrayXd col_as_double(std::string const &cn) const;
+  Eigen::ArrayXd col_as_double(column_t cid) const;
+
+  // Builds the all-double EventFrame equivalent of this frame
+  EventFrame as_EventFrame() const;
+
+  // Resizes every column to rows, keeping the first min(rows, num_rows)
+  // entries
+  void conservativeResize(size_t rows);
+
+  // Build a new event frame from a copy of the referenced rows.
+  TypedEventFrame topRows(size_t rows) const;
+
+  // Concatenates frames with identical columns, in order
+  static TypedEventFrame
+  Concatenate(std::vector<TypedEventFrame> const &frames);
+
+  // bytes used by the column data
+  size_t data_size() const;
+
+  explicit operator bool() const { return num_rows; }
+
+private:
+  // the index of each column within the storage for its type
+  std::vector<size_t> column_storage_index;
+
+  std::vector<column_array_t<bool>> cols_bool;
+  std::vector<column_array_t<int>> cols_int;
+  std::vector<column_array_t<uint>> cols_uint;
+  std::vector<column_array_t<int16_t>> cols_int16_t;
+  std::vector<column_array_t<uint16_t>> cols_uint16_t;
+  std::vector<column_array_t<float>> cols_float;
+  std::vector<column_array_t<double>> cols_double;
+
+  template <typename T> void require_column_type(column_t cid) const {
+    if (cid >= column_typenums.size()) {
+      throw InvalidFrameColumnName()
+          << "TypedEventFrame has no column " << cid;
+    }
+    if (column_typenums[cid] != column_type<T>::id) {
+      throw InvalidFrameColumnType()
+          << "TypedEventFrame column " << column_names[cid] << " is of type "
+          << column_typenum_as_string(column_typenums[cid])
+          << ", but was requested as "
+          << column_typenum_as_string(column_type<T>::id);
+    }
+  }
+
+  template <typename T> std::vector<column_array_t<T>> &get_storage() {
+    return const_cast<std::vector<column_array_t<T>> &>(
+        static_cast<TypedEventFrame const *>(this)->get_storage<T>());
+  }
+
+  template <typename T>
+  std::vector<column_array_t<T>> const &get_storage() const {
+    if constexpr (std::is_same_v<T, bool>) {
+      return cols_bool;
+    } else if constexpr (std::is_same_v<T, int>) {
+      return cols_int;
+    } else if constexpr (std::is_same_v<T, uint>) {
+      return cols_uint;
+    } else if constexpr (std::is_same_v<T, int16_t>) {
+      return cols_int16_t;
+    } else if constexpr (std::is_same_v<T, uint16_t>) {
+      return cols_uint16_t;
+    } else if constexpr (std::is_same_v<T, float>) {
+      return cols_float;
+    } else if constexpr (std::is_same_v<T, double>) {
+      return cols_double;
+    }
+  }
+};
+
+std::ostream &operator<<(std::ostream &os, nuis::TypedEventFrame const &);
+
+} // namespace nuis
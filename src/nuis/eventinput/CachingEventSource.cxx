@@ -0,0 +1,110 @@
+#include "nuis/eventinput/CachingEventSource.h"
+
+#include "nuis/log.txx"
+
+#include "NuHepMC/HepMC3Features.hxx"
+#include "NuHepMC/make_writer.hxx"
+
+#include "HepMC3/Attribute.h"
+#include "HepMC3/GenRunInfo.h"
+#include "HepMC3/Writer.h"
+
+#include "fmt/core.h"
+
+#include <unistd.h>
+
+namespace nuis {
+
+CachingEventSource::CachingEventSource(IEventSourcePtr evs,
+                                       std::filesystem::path const &cp,
+                                       std::string const &pn)
+    : IEventSourceWrapper(evs), cache_path(cp), plugin_name(pn) {
+  // keep the real extension last so that the writer can be deduced from it
+  tmp_path = cache_path.parent_path() /
+             fmt::format("tmp.{}.{}.{}", getpid(), fmt::ptr(this),
+                         cache_path.filename().native());
+}
+
+void CachingEventSource::abandon() {
+  if (!writer) {
+    return;
+  }
+  writer->close();
+  writer.reset();
+  std::error_code ec;
+  std::filesystem::remove(tmp_path, ec);
+}
+
+std::shared_ptr<HepMC3::GenEvent> CachingEventSource::first() {
+  abandon();
+
+  if (!wrapped_ev_source) {
+    return nullptr;
+  }
+
+  auto ev = wrapped_ev_source->first();
+  if (!ev) {
+    return nullptr;
+  }
+
+  // events are written with the run info of the source, so the attribute is
+  // added to it rather than to a copy
+  if (plugin_name.size() && ev->run_info()) {
+    ev->run_info()->add_attribute(
+        EventCachePluginAttribute,
+        std::make_shared<HepMC3::StringAttribute>(plugin_name));
+  }
+
+  try {
+    writer = NuHepMC::Writer::make_writer(tmp_path.native(), ev->run_info());
+  } catch (std::exception const &ex) {
+    // e.g. a cache_format that this build of HepMC3 cannot write
+    log_warn("[CachingEventSource]: {}", ex.what());
+    writer.reset();
+  }
+  if (!writer || writer->failed()) {
+    log_warn("[CachingEventSource]: failed to open cache file {} for writing, "
+             "events will not be cached.",
+             tmp_path.native());
+    writer.reset();
+    return ev;
+  }
+
+  log_debug("[CachingEventSource]: writing event cache to {}",
+            cache_path.native());
+  writer->write_event(*ev);
+  return ev;
+}
+
+std::shared_ptr<HepMC3::GenEvent> CachingEventSource::next() {
+  auto ev = wrapped_ev_source->next();
+
+  if (!writer) {
+    return ev;
+  }
+
+  if (ev) {
+    writer->write_event(*ev);
+    return ev;
+  }
+
+  writer->close();
+  writer.reset();
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, cache_path, ec);
+  if (ec) {
+    log_warn("[CachingEventSource]: failed to move completed cache file {} to "
+             "{}: {}",
+             tmp_path.native(), cache_path.native(), ec.message());
+    std::filesystem::remove(tmp_path, ec);
+  } else {
+    log_info("[CachingEventSource]: wrote event cache {}", cache_path.native());
+  }
+
+  return ev;
+}
+
+CachingEventSource::~CachingEventSource() { abandon(); }
+
+} // namespace nuis
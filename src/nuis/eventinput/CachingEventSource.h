@@ -0,0 +1,43 @@
+#pragma once
+
+#include "nuis/eventinput/IEventSource.h"
+#include "nuis/eventinput/IEventSourceWrapper.h"
+
+#include <filesystem>
+#include <string>
+
+namespace HepMC3 {
+class Writer;
+}
+
+namespace nuis {
+
+// GenRunInfo string attribute naming the plugin that read the events that an
+// event cache was written from
+inline std::string const EventCachePluginAttribute =
+    "NUISANCE.EventCache.Plugin";
+
+/// An event source wrapper that tees every event read from the wrapped source
+/// into a NuHepMC file. The file is written under a temporary name and only
+/// moved to cache_path once the wrapped source has been read to exhaustion, so
+/// a partially written cache is never picked up by a later job.
+class CachingEventSource : public IEventSource, public IEventSourceWrapper {
+
+  std::filesystem::path cache_path;
+  std::filesystem::path tmp_path;
+  std::string plugin_name;
+  std::shared_ptr<HepMC3::Writer> writer;
+
+  void abandon();
+
+public:
+  CachingEventSource(IEventSourcePtr evs, std::filesystem::path const &cp,
+                     std::string const &plugin_name = "");
+
+  std::shared_ptr<HepMC3::GenEvent> first();
+  std::shared_ptr<HepMC3::GenEvent> next();
+
+  virtual ~CachingEventSource();
+};
+
+} // namespace nuis
@@ -3,6 +3,10 @@
 #include "nuis/log.txx"
 #include "nuis/except.h"
 
+#ifdef NUIS_EVENTINPUT_ROOT_ENABLED
+#include "TROOT.h"
+#endif
+
 #include <numeric>
 
 namespace nuis {
@@ -26,15 +30,47 @@ CombinedNormalizedEventSource::CombinedNormalizedEventSource(
 }
 
 NormalizedEventSourcePtr CombinedNormalizedEventSource::SumEventSources(
-    std::vector<NormalizedEventSourcePtr> components) {
-  return std::shared_ptr<CombinedNormalizedEventSource>(
+    std::vector<NormalizedEventSourcePtr> components,
+    size_t read_ahead_depth) {
+  auto evs = std::shared_ptr<CombinedNormalizedEventSource>(
       new CombinedNormalizedEventSource(kAdd, components));
+  if (read_ahead_depth) {
+    evs->read_ahead(read_ahead_depth);
+  }
+  return evs;
 }
 
 NormalizedEventSourcePtr CombinedNormalizedEventSource::AverageEventSources(
-    std::vector<NormalizedEventSourcePtr> components) {
-  return std::shared_ptr<CombinedNormalizedEventSource>(
+    std::vector<NormalizedEventSourcePtr> components,
+    size_t read_ahead_depth) {
+  auto evs = std::shared_ptr<CombinedNormalizedEventSource>(
       new CombinedNormalizedEventSource(kAvg, components));
+  if (read_ahead_depth) {
+    evs->read_ahead(read_ahead_depth);
+  }
+  return evs;
+}
+
+bool CombinedNormalizedEventSource::set_prefilter(EventHeaderFilterFunc filt) {
+  bool all_pushed_down = true;
+  for (auto &[status, evs] : comp_evs) {
+    all_pushed_down = evs->set_prefilter(filt) && all_pushed_down;
+  }
+  return all_pushed_down;
+}
+
+void CombinedNormalizedEventSource::read_ahead(size_t depth) {
+  NUIS_LOG_TRACE("[CombinedNormalizedEventSource] reading {} components "
+                 "concurrently with a buffer depth of {} events.",
+                 comp_evs.size(), depth);
+#ifdef NUIS_EVENTINPUT_ROOT_ENABLED
+  // ROOT-based components are now read concurrently, whether or not they were
+  // built with thread_safe: true
+  ROOT::EnableThreadSafety();
+#endif
+  for (auto &[status, evs] : comp_evs) {
+    evs->read_ahead(depth);
+  }
 }
 
 size_t CombinedNormalizedEventSource::next_src() {
@@ -124,6 +160,21 @@ std::optional<EventCVWeightPair> CombinedNormalizedEventSource::next() {
   return ev;
 }
 
+size_t
+CombinedNormalizedEventSource::next_batch(std::vector<EventCVWeightPair> &batch,
+                                          size_t n) {
+  // keep the round-robin order of next()
+  batch.clear();
+  while (batch.size() < n) {
+    auto ev = next();
+    if (!ev) {
+      break;
+    }
+    batch.push_back(std::move(ev.value()));
+  }
+  return batch.size();
+}
+
 NormInfo CombinedNormalizedEventSource::norm_info(
     NuHepMC::CrossSection::Units::Unit const &units) {
 
@@ -21,14 +21,27 @@ class CombinedNormalizedEventSource : public NormalizedEventSource {
   size_t next_src();
 
 public:
+  // If read_ahead_depth is non-zero, each component decodes events on its own
+  // thread into a buffer of that depth. Events are still emitted in the same
+  // round-robin order as the serial mode and the FATX accumulation happens on
+  // the caller's thread, so results and norm_info are identical.
+  // ROOT's thread safety is enabled when read-ahead is turned on, as
+  // components may be ROOT-based.
   static NormalizedEventSourcePtr
-  SumEventSources(std::vector<NormalizedEventSourcePtr> components);
+  SumEventSources(std::vector<NormalizedEventSourcePtr> components,
+                  size_t read_ahead_depth = 0);
 
   static NormalizedEventSourcePtr
-  AverageEventSources(std::vector<NormalizedEventSourcePtr> components);
+  AverageEventSources(std::vector<NormalizedEventSourcePtr> components,
+                      size_t read_ahead_depth = 0);
 
   std::optional<EventCVWeightPair> first();
   std::optional<EventCVWeightPair> next();
+  size_t next_batch(std::vector<EventCVWeightPair> &batch, size_t n);
+
+  // returns true only if every component could push the filter down
+  bool set_prefilter(EventHeaderFilterFunc filt);
+  void read_ahead(size_t depth);
 
   NormInfo norm_info(NuHepMC::CrossSection::Units::Unit const &units);
   virtual ~CombinedNormalizedEventSource();
@@ -0,0 +1,95 @@
+#include "nuis/eventinput/EntryRangeEventSource.h"
+
+#include "nuis/log.txx"
+
+#include <algorithm>
+
+namespace nuis {
+
+EntryRangeEventSource::EntryRangeEventSource(IEventSourcePtr evs, size_t begin,
+                                             size_t end)
+    : IEventSourceWrapper(evs), begin_entry{begin}, end_entry{end},
+      cursor{begin} {}
+
+std::shared_ptr<HepMC3::GenEvent> EntryRangeEventSource::first() {
+  if (!wrapped_ev_source || (begin_entry >= end_entry)) {
+    return nullptr;
+  }
+
+  auto ev = wrapped_ev_source->first();
+  if (!ev) {
+    return nullptr;
+  }
+
+  // cursor always points at the entry that the next call to next() returns
+  cursor = begin_entry + 1;
+  if (!begin_entry) {
+    return ev;
+  }
+
+  if (wrapped_ev_source->seekable()) {
+    return wrapped_ev_source->read(begin_entry);
+  }
+
+  log_debug("[EntryRangeEventSource]: wrapped source is not seekable, "
+            "skipping {} events to reach the start of the range.",
+            begin_entry);
+  for (size_t i = 0; ev && (i < begin_entry); ++i) {
+    ev = wrapped_ev_source->next();
+  }
+  return ev;
+}
+
+std::shared_ptr<HepMC3::GenEvent> EntryRangeEventSource::next() {
+  if (cursor >= end_entry) {
+    return nullptr;
+  }
+  cursor++;
+  return wrapped_ev_source->next();
+}
+
+size_t EntryRangeEventSource::next_batch(
+    std::vector<std::shared_ptr<HepMC3::GenEvent>> &batch, size_t n) {
+  if (cursor >= end_entry) {
+    batch.clear();
+    return 0;
+  }
+  size_t nread =
+      wrapped_ev_source->next_batch(batch, std::min(n, end_entry - cursor));
+  cursor += nread;
+  return nread;
+}
+
+bool EntryRangeEventSource::set_prefilter(EventHeaderFilterFunc filt) {
+  return wrapped_ev_source && wrapped_ev_source->set_prefilter(filt);
+}
+
+bool EntryRangeEventSource::seekable() {
+  return wrapped_ev_source && wrapped_ev_source->seekable();
+}
+
+size_t EntryRangeEventSource::size() {
+  if (!wrapped_ev_source) {
+    return 0;
+  }
+  size_t wrapped_size = wrapped_ev_source->size();
+  if (wrapped_size <= begin_entry) {
+    return 0;
+  }
+  return std::min(wrapped_size, end_entry) - begin_entry;
+}
+
+bool EntryRangeEventSource::seek(size_t entry) {
+  if ((begin_entry + entry) >= end_entry) {
+    return false;
+  }
+  if (!wrapped_ev_source->seek(begin_entry + entry)) {
+    return false;
+  }
+  cursor = begin_entry + entry;
+  return true;
+}
+
+EntryRangeEventSource::~EntryRangeEventSource() {}
+
+} // namespace nuis
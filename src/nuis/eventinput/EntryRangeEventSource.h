@@ -0,0 +1,35 @@
+#pragma once
+
+#include "nuis/eventinput/IEventSource.h"
+#include "nuis/eventinput/IEventSourceWrapper.h"
+
+namespace nuis {
+
+/// An event source wrapper that only yields entries [begin, end) of the wrapped
+/// source. Seekable sources jump straight to begin, others are skipped through
+/// event by event.
+class EntryRangeEventSource : public IEventSource, public IEventSourceWrapper {
+
+  size_t begin_entry;
+  size_t end_entry;
+  size_t cursor;
+
+public:
+  EntryRangeEventSource(IEventSourcePtr evs, size_t begin, size_t end);
+
+  std::shared_ptr<HepMC3::GenEvent> first();
+  std::shared_ptr<HepMC3::GenEvent> next();
+  size_t next_batch(std::vector<std::shared_ptr<HepMC3::GenEvent>> &batch,
+                    size_t n);
+
+  bool set_prefilter(EventHeaderFilterFunc filt);
+
+  // entries are counted relative to the start of the range
+  bool seekable();
+  size_t size();
+  bool seek(size_t entry);
+
+  virtual ~EntryRangeEventSource();
+};
+
+} // namespace nuis
@@ -0,0 +1,355 @@
+#include "nuis/eventinput/EventIndex.h"
+#include "nuis/eventinput/Fingerprint.h"
+
+#include "nuis/env.h"
+#include "nuis/except.h"
+#include "nuis/log.txx"
+
+#include "NuHepMC/FATXUtils.hxx"
+#include "NuHepMC/UnitsUtils.hxx"
+
+#include "HepMC3/GenEvent.h"
+
+#include "fmt/core.h"
+
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <random>
+
+#include <unistd.h>
+
+DECLARE_NUISANCE_EXCEPT(InvalidEventIndexUnits);
+DECLARE_NUISANCE_EXCEPT(EventIndexSizeMismatch);
+DECLARE_NUISANCE_EXCEPT(EventIndexEntryMismatch);
+
+namespace nuis {
+
+namespace {
+// index files hold the magic bytes, the format version, whether CV weights
+// are stored, the normalisation, the number of entries and then the entries
+// and weights, all in native byte order
+constexpr char const index_magic[8] = {'N', 'U', 'I', 'S', 'E', 'I', 'D', 'X'};
+constexpr uint32_t const index_version = 1;
+
+template <typename T> void write_pod(std::ostream &os, T const &v) {
+  os.write(reinterpret_cast<char const *>(&v), sizeof(T));
+}
+template <typename T> void read_pod(std::istream &is, T &v) {
+  is.read(reinterpret_cast<char *>(&v), sizeof(T));
+}
+} // namespace
+
+NormInfo
+EventIndex::norm_info(NuHepMC::CrossSection::Units::Unit const &units) const {
+  using namespace NuHepMC::CrossSection::Units;
+  static std::map<Scale, double> const xsunit_factors = {
+      {Scale::pb, pb},
+      {Scale::cm2, cm2},
+      {Scale::cm2_ten38, cm2_ten38},
+  };
+
+  double fatx_pb = 0;
+  if (units.tgtscale == TargetScale::PerAtom) {
+    fatx_pb = fatx_pb_per_target;
+  } else if (units.tgtscale == TargetScale::PerNucleon) {
+    fatx_pb = fatx_pb_per_nucleon;
+  } else {
+    throw InvalidEventIndexUnits()
+        << "EventIndex stores the fatx per target and per nucleon, cannot "
+           "convert it to "
+        << units;
+  }
+  return {fatx_pb * (pb / xsunit_factors.at(units.scale)), sumweights,
+          nevents};
+}
+
+bool EventIndex::matches(IEventSource &entry_source) const {
+  if (!entries.size()) {
+    return true;
+  }
+  for (size_t i : {size_t(0), entries.size() / 2, entries.size() - 1}) {
+    auto ev = entry_source.read(entries[i]);
+    if (!ev || (size_t(ev->event_number()) != entries[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EventIndex::write(std::filesystem::path const &path) const {
+  uint8_t has_weights = cv_weights.size() ? 1 : 0;
+  uint64_t nentries = entries.size();
+
+  // write then move so that concurrent jobs never read a partial file
+  auto tmp_path = path;
+  tmp_path +=
+      fmt::format(".{}.{:08x}.tmp", getpid(), std::random_device{}());
+  std::error_code ec;
+  {
+    std::ofstream fout(tmp_path, std::ios::binary);
+    fout.write(index_magic, 8);
+    write_pod(fout, index_version);
+    write_pod(fout, has_weights);
+    write_pod(fout, fatx_pb_per_target);
+    write_pod(fout, fatx_pb_per_nucleon);
+    write_pod(fout, sumweights);
+    write_pod(fout, uint64_t(nevents));
+    write_pod(fout, nentries);
+    for (auto e : entries) {
+      write_pod(fout, uint64_t(e));
+    }
+    if (has_weights) {
+      fout.write(reinterpret_cast<char const *>(cv_weights.data()),
+                 nentries * sizeof(double));
+    }
+    if (!fout) {
+      log_warn("Failed to write event index {}", tmp_path.native());
+      fout.close();
+      std::filesystem::remove(tmp_path, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    log_warn("Failed to move event index to {}: {}", path.native(),
+             ec.message());
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+std::optional<EventIndex> EventIndex::read(std::filesystem::path const &path) {
+  std::ifstream fin(path, std::ios::binary);
+  if (!fin) {
+    return std::optional<EventIndex>();
+  }
+
+  char magic[8];
+  uint32_t version = 0;
+  uint8_t has_weights = 0;
+  uint64_t nevents = 0, nentries = 0;
+  EventIndex idx;
+
+  fin.read(magic, 8);
+  read_pod(fin, version);
+  if (!fin || !std::equal(magic, magic + 8, index_magic) ||
+      (version != index_version)) {
+    log_warn("Ignoring invalid event index {}", path.native());
+    return std::optional<EventIndex>();
+  }
+
+  read_pod(fin, has_weights);
+  read_pod(fin, idx.fatx_pb_per_target);
+  read_pod(fin, idx.fatx_pb_per_nucleon);
+  read_pod(fin, idx.sumweights);
+  read_pod(fin, nevents);
+  read_pod(fin, nentries);
+  idx.nevents = nevents;
+
+  idx.entries.reserve(nentries);
+  for (uint64_t i = 0; fin && (i < nentries); ++i) {
+    uint64_t e = 0;
+    read_pod(fin, e);
+    idx.entries.push_back(e);
+  }
+  if (has_weights) {
+    idx.cv_weights.resize(nentries);
+    fin.read(reinterpret_cast<char *>(idx.cv_weights.data()),
+             nentries * sizeof(double));
+  }
+  if (!fin) {
+    log_warn("Ignoring truncated event index {}", path.native());
+    return std::optional<EventIndex>();
+  }
+  return idx;
+}
+
+std::optional<EventIndex>
+BuildEventIndex(NormalizedEventSourcePtr evs, IEventSourcePtr entry_source,
+                std::function<int(HepMC3::GenEvent const &)> const &sel,
+                bool store_weights) {
+  EventIndex idx;
+  long last_number = -1;
+  for (auto ev = evs->first(); ev; ev = evs->next()) {
+    // entries can only increase, whatever wrappers select them
+    if (ev->evt->event_number() <= last_number) {
+      log_warn("Not indexing events: event number {} follows {}, the event "
+               "numbers are not entry numbers.",
+               ev->evt->event_number(), last_number);
+      return std::optional<EventIndex>();
+    }
+    last_number = ev->evt->event_number();
+
+    if (!sel(*ev->evt)) {
+      continue;
+    }
+    idx.entries.push_back(ev->evt->event_number());
+    if (store_weights) {
+      idx.cv_weights.push_back(ev->cv_weight);
+    }
+  }
+
+  auto [fatx_pt, sumweights, nevents] =
+      evs->norm_info(NuHepMC::CrossSection::Units::pb_PerAtom);
+  idx.fatx_pb_per_target = fatx_pt;
+  idx.fatx_pb_per_nucleon =
+      evs->norm_info(NuHepMC::CrossSection::Units::pb_PerNucleon).fatx;
+  idx.sumweights = sumweights;
+  idx.nevents = nevents;
+
+  if (!idx.matches(*entry_source)) {
+    log_warn("Not indexing events: the event numbers are not the entry "
+             "numbers of the seekable input.");
+    return std::optional<EventIndex>();
+  }
+
+  log_info("Indexed {} of {} events.", idx.entries.size(), idx.nevents);
+  return idx;
+}
+
+std::filesystem::path EventIndexPath(YAML::Node const &cfg,
+                                     std::string const &selection_name) {
+  auto fingerprint = EventSourceFingerprint(cfg);
+  if (!fingerprint) {
+    return {};
+  }
+
+  // the fingerprint ignores these, but they change which events are indexed
+  for (auto const &key : {"entry_range", "subsample", "subsample_seed"}) {
+    if (cfg[key]) {
+      fingerprint = StableHash(key + YAML::Dump(cfg[key]), fingerprint);
+    }
+  }
+  fingerprint = StableHash(selection_name, fingerprint);
+
+  std::filesystem::path first_input =
+      cfg["filepath"] ? cfg["filepath"].as<std::string>()
+                      : cfg["filepaths"].as<std::vector<std::string>>().front();
+
+  std::filesystem::path index_dir =
+      cfg["index_dir"]
+          ? cfg["index_dir"].as<std::string>()
+          : env::NUISANCE_EVENT_CACHE_DIR(
+                std::filesystem::absolute(first_input).parent_path());
+
+  std::error_code ec;
+  std::filesystem::create_directories(index_dir, ec);
+  if (ec) {
+    log_warn("Failed to create event index directory {}: {}",
+             index_dir.native(), ec.message());
+    return {};
+  }
+
+  // the selection name is hashed into the fingerprint, so replacing
+  // characters that are not safe in a filename cannot cause collisions
+  std::string safe_name = selection_name;
+  for (auto &c : safe_name) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && (c != '-') &&
+        (c != '_')) {
+      c = '_';
+    }
+  }
+
+  return index_dir / fmt::format("{}.{}.{:016x}.nuisidx",
+                                 first_input.stem().native(), safe_name,
+                                 fingerprint);
+}
+
+IndexedNormalizedEventSource::IndexedNormalizedEventSource(
+    IEventSourcePtr evs, std::shared_ptr<EventIndex const> idx)
+    : NormalizedEventSource(evs), entry_source{evs}, index{idx},
+      index_it{0}, last_entry{0} {
+  if (index->cv_weights.size() &&
+      (index->cv_weights.size() != index->entries.size())) {
+    throw EventIndexSizeMismatch()
+        << "EventIndex has " << index->entries.size() << " entries but "
+        << index->cv_weights.size() << " CV weights.";
+  }
+}
+
+std::optional<EventCVWeightPair> IndexedNormalizedEventSource::read_indexed() {
+  while (index_it < index->entries.size()) {
+    size_t entry = index->entries[index_it];
+
+    // runs of consecutive entries are read without seeking
+    auto ev = (index_it && (entry == (last_entry + 1)))
+                  ? entry_source->next()
+                  : entry_source->read(entry);
+    last_entry = entry;
+    if (!ev) {
+      log_warn("IndexedNormalizedEventSource failed to read entry {}, the "
+               "index does not match the input.",
+               entry);
+      index_it = index->entries.size();
+      return std::optional<EventCVWeightPair>();
+    }
+
+    if (size_t(ev->event_number()) != entry) {
+      throw EventIndexEntryMismatch()
+          << "IndexedNormalizedEventSource read event number "
+          << ev->event_number() << " from entry " << entry
+          << ", the event index is stale or the input does not number events "
+             "by entry. Remove the index file to rebuild it.";
+    }
+
+    double cvw = index->cv_weights.size() ? index->cv_weights[index_it]
+                                          : weight_acc->process(*ev);
+    index_it++;
+
+    if (converted_prefilter && !converted_prefilter(GetEventHeader(*ev))) {
+      continue;
+    }
+    return EventCVWeightPair{ev, cvw};
+  }
+  return std::optional<EventCVWeightPair>();
+}
+
+std::optional<EventCVWeightPair> IndexedNormalizedEventSource::first() {
+  index_it = 0;
+  if (!index->entries.size()) {
+    return std::optional<EventCVWeightPair>();
+  }
+
+  if (!index->cv_weights.size()) {
+    auto ev = entry_source->first();
+    if (!ev) {
+      return std::optional<EventCVWeightPair>();
+    }
+    weight_acc = NuHepMC::FATX::MakeAccumulator(ev->run_info());
+  }
+  return read_indexed();
+}
+
+std::optional<EventCVWeightPair> IndexedNormalizedEventSource::next() {
+  return read_indexed();
+}
+
+size_t
+IndexedNormalizedEventSource::next_batch(std::vector<EventCVWeightPair> &batch,
+                                         size_t n) {
+  batch.clear();
+  while (batch.size() < n) {
+    auto ev = read_indexed();
+    if (!ev) {
+      break;
+    }
+    batch.push_back(std::move(ev.value()));
+  }
+  return batch.size();
+}
+
+bool IndexedNormalizedEventSource::set_prefilter(EventHeaderFilterFunc filt) {
+  converted_prefilter = filt;
+  return false;
+}
+
+NormInfo IndexedNormalizedEventSource::norm_info(
+    NuHepMC::CrossSection::Units::Unit const &units) {
+  return index->norm_info(units);
+}
+
+IndexedNormalizedEventSource::~IndexedNormalizedEventSource() {}
+
+} // namespace nuis
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "nuis/eventinput/NormalizedEventSource.h"
+
+#include "yaml-cpp/yaml.h"
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace NuHepMC::FATX {
+class Accumulator;
+} // namespace NuHepMC::FATX
+
+namespace nuis {
+
+/// The entries of a seekable input that passed an analysis selection, and the
+/// normalisation of the full pass that selected them. Entries are the event
+/// numbers that the seekable plugin sources assign, which are their entry
+/// numbers in the input.
+struct EventIndex {
+  std::vector<size_t> entries;
+  // the CV weights of entries, empty if they were not stored
+  std::vector<double> cv_weights;
+
+  double fatx_pb_per_target;
+  double fatx_pb_per_nucleon;
+  double sumweights;
+  size_t nevents;
+
+  NormInfo norm_info(NuHepMC::CrossSection::Units::Unit const &units) const;
+
+  // checks that entry_source reads the first, middle and last entries with
+  // matching event numbers, an index that fails this is stale or was built
+  // from an input that numbers its own events
+  bool matches(IEventSource &entry_source) const;
+
+  // returns false if the index could not be written
+  bool write(std::filesystem::path const &path) const;
+  // returns an empty optional if path is not a valid index file
+  static std::optional<EventIndex> read(std::filesystem::path const &path);
+};
+
+// Reads evs from first() to the end and indexes the events for which sel
+// returns non-zero. Returns an empty optional if the event numbers of evs are
+// not the entry numbers of entry_source, the seekable source that evs wraps.
+std::optional<EventIndex> BuildEventIndex(
+    NormalizedEventSourcePtr evs, IEventSourcePtr entry_source,
+    std::function<int(HepMC3::GenEvent const &)> const &sel,
+    bool store_weights = true);
+
+// The index file for selection_name on the inputs of an EventSourceFactory
+// configuration node, written to index_dir if set, then
+// $NUISANCE_EVENT_CACHE_DIR, and otherwise next to the first input file.
+// Returns an empty path if the inputs cannot be fingerprinted.
+std::filesystem::path EventIndexPath(YAML::Node const &cfg,
+                                     std::string const &selection_name);
+
+/// Reads only the indexed entries of a seekable event source, the norm_info
+/// is that of the full pass that built the index.
+class IndexedNormalizedEventSource : public NormalizedEventSource {
+
+  IEventSourcePtr entry_source;
+  std::shared_ptr<EventIndex const> index;
+
+  size_t index_it;
+  // the last entry read, so that runs of entries are read without seeking
+  size_t last_entry;
+
+  // only used to weight events when the index did not store CV weights
+  std::shared_ptr<NuHepMC::FATX::Accumulator> weight_acc;
+
+  EventHeaderFilterFunc converted_prefilter;
+
+  std::optional<EventCVWeightPair> read_indexed();
+
+public:
+  IndexedNormalizedEventSource(IEventSourcePtr evs,
+                               std::shared_ptr<EventIndex const> index);
+
+  std::optional<EventCVWeightPair> first();
+  std::optional<EventCVWeightPair> next();
+  size_t next_batch(std::vector<EventCVWeightPair> &batch, size_t n);
+
+  // applied to the read events, the normalisation is fixed by the index
+  bool set_prefilter(EventHeaderFilterFunc filt);
+  void read_ahead(size_t) {}
+
+  NormInfo norm_info(NuHepMC::CrossSection::Units::Unit const &units);
+  virtual ~IndexedNormalizedEventSource();
+};
+
+} // namespace nuis
@@ -1,6 +1,13 @@
 #include "nuis/eventinput/EventSourceFactory.h"
 
+#include "nuis/eventinput/CachingEventSource.h"
+#include "nuis/eventinput/EntryRangeEventSource.h"
+#include "nuis/eventinput/EventIndex.h"
+#include "nuis/eventinput/Fingerprint.h"
 #include "nuis/eventinput/HepMC3EventSource.h"
+#include "nuis/eventinput/ReadAheadEventSource.h"
+#include "nuis/eventinput/SubsampledEventSource.h"
+#include "nuis/eventinput/UnweightedNormalizedEventSource.h"
 
 #include "nuis/env.h"
 #include "nuis/except.h"
@@ -18,7 +25,10 @@
 #include "fmt/core.h"
 #include "fmt/ranges.h"
 
+#include <map>
+#include <mutex>
 #include <regex>
+#include <set>
 
 namespace nuis {
 
@@ -87,69 +97,199 @@ EventSourceFactory::EventSourceFactory() : resolv() {
 #ifdef NUISANCE_USE_BOOSTDLL
   std::filesystem::path shared_library_dir{NUISANCE};
   shared_library_dir /= "lib/plugins";
-  std::regex plugin_re("nuisplugin-eventinput-.*.so");
+  std::regex plugin_re("nuisplugin-eventinput-(.*).so");
   for (auto const &dir_entry :
        std::filesystem::directory_iterator{shared_library_dir}) {
-    if (std::regex_match(dir_entry.path().filename().native(), plugin_re)) {
+    std::smatch plugin_match;
+    std::string const &plugin_filename = dir_entry.path().filename().native();
+    if (std::regex_match(plugin_filename, plugin_match, plugin_re)) {
       log_debug("Found eventinput plugin: {}", dir_entry.path().native());
-      pluginfactories.emplace(
-          dir_entry.path(),
-          boost::dll::import_alias<IEventSource_PluginFactory_t>(
-              dir_entry.path().native(), "MakeEventSource"));
+      plugins.push_back(EventInputPlugin{
+          plugin_match[1].str(),
+          boost::dll::import_alias<bool(std::filesystem::path const &)>(
+              dir_entry.path().native(), "CanReadFile"),
+          boost::dll::import_alias<IEventSourcePtr(YAML::Node const &)>(
+              dir_entry.path().native(), "MakeEventSource")});
     }
   }
+#else
+#ifdef NUIS_EVENTINPUT_neutvect_Enabled
+  plugins.push_back(EventInputPlugin{"neutvect",
+                                     neutvectEventSource::CanReadFile,
+                                     neutvectEventSource::MakeEventSource});
+#endif
+#ifdef NUIS_EVENTINPUT_GHEP3_Enabled
+  plugins.push_back(EventInputPlugin{"GHEP3", GHEP3EventSource::CanReadFile,
+                                     GHEP3EventSource::MakeEventSource});
+#endif
+#ifdef NUIS_EVENTINPUT_NUISANCE2FlatTree_Enabled
+  plugins.push_back(
+      EventInputPlugin{"NUISANCE2FlatTree",
+                       NUISANCE2FlatTreeEventSource_CanReadFile,
+                       NUISANCE2FlatTreeEventSource_MakeEventSource});
+#endif
+#ifdef NUIS_EVENTINPUT_NuWroevent1_Enabled
+  plugins.push_back(EventInputPlugin{"NuWroevent1",
+                                     NuWroevent1EventSource_CanReadFile,
+                                     NuWroevent1EventSource_MakeEventSource});
+#endif
 #endif
 }
 
-#ifndef NUISANCE_USE_BOOSTDLL
-IEventSourcePtr TryAllKnownEventInputPlugins(YAML::Node const &cfg) {
+// The name of the plugin that last opened a given input, keyed on the
+// canonical path and shared by every factory in the process.
+class PathPlugins {
+  std::mutex m;
+  std::map<std::filesystem::path, std::string> plugins;
 
-  bool plugin_specified = bool(cfg["plugin_name"]);
-  std::string const &plugin_name =
-      plugin_specified ? cfg["plugin_name"].as<std::string>() : "";
+  static std::filesystem::path key(std::filesystem::path const &path) {
+    std::error_code ec;
+    auto canon = std::filesystem::weakly_canonical(path, ec);
+    return ec ? path : canon;
+  }
 
-#ifdef NUIS_EVENTINPUT_neutvect_Enabled
-  if (!plugin_specified || plugin_name == "neutvect") {
-    auto es = neutvectEventSource::MakeEventSource(cfg);
-    if (es->first()) {
-      log_debug("Plugin neutvectEventSource is able to read file");
-      return es;
-    }
+public:
+  static PathPlugins &get() {
+    static PathPlugins path_plugins;
+    return path_plugins;
   }
-#endif
 
-#ifdef NUIS_EVENTINPUT_GHEP3_Enabled
-  if (!plugin_specified || plugin_name == "GHEP3") {
-    auto es = GHEP3EventSource::MakeEventSource(cfg);
-    if (es->first()) {
-      log_debug("Plugin GHEP3EventSource is able to read file");
-      return es;
-    }
+  std::string find(std::filesystem::path const &path) {
+    auto k = key(path);
+    std::lock_guard<std::mutex> lk(m);
+    auto it = plugins.find(k);
+    return (it == plugins.end()) ? std::string() : it->second;
   }
-#endif
 
-#ifdef NUIS_EVENTINPUT_NUISANCE2FlatTree_Enabled
-  if (!plugin_specified || plugin_name == "NUISANCE2FlatTree") {
-    auto es = NUISANCE2FlatTreeEventSource_MakeEventSource(cfg);
-    if (es->first()) {
-      log_debug("Plugin NUISANCE2FlatTreeEventSource is able to read file");
-      return es;
-    }
+  void set(std::filesystem::path const &path, std::string const &name) {
+    auto k = key(path);
+    std::lock_guard<std::mutex> lk(m);
+    plugins[k] = name;
   }
-#endif
 
-#ifdef NUIS_EVENTINPUT_NuWroevent1_Enabled
-  if (!plugin_specified || plugin_name == "NuWroevent1") {
-    auto es = NuWroevent1EventSource_MakeEventSource(cfg);
-    if (es->first()) {
-      log_debug("Plugin NuWroevent1EventSource is able to read file");
-      return es;
+  void erase(std::filesystem::path const &path) {
+    auto k = key(path);
+    std::lock_guard<std::mutex> lk(m);
+    plugins.erase(k);
+  }
+};
+
+// read_ahead: true uses the default queue depth, read_ahead: <N> uses a queue
+// depth of N events.
+size_t ReadAheadRequested(YAML::Node const &cfg) {
+  if (!cfg["read_ahead"]) {
+    return 0;
+  }
+  return cfg["read_ahead"].as<size_t>(
+      cfg["read_ahead"].as<bool>(false)
+          ? ReadAheadEventSource::default_queue_depth
+          : 0);
+}
+
+// cache: true enables the event cache, which is written to cache_dir if set,
+// then $NUISANCE_EVENT_CACHE_DIR, and otherwise next to the first input file.
+// cache_format sets the NuHepMC file extension of the cache, hepmc3 by default
+// as protobuf support is optional. Caches only hold the HepMC3 events, so
+// weight calcs that need the generator's own event records refuse them, see
+// EventCachePluginAttribute.
+std::filesystem::path EventCachePath(YAML::Node const &cfg) {
+  if (!cfg["cache"] || !cfg["cache"].as<bool>()) {
+    return {};
+  }
+
+  auto fingerprint = EventSourceFingerprint(cfg);
+  if (!fingerprint) {
+    log_warn("Event caching was requested but the input files could not be "
+             "fingerprinted, events will not be cached.");
+    return {};
+  }
+
+  std::filesystem::path first_input =
+      cfg["filepath"] ? cfg["filepath"].as<std::string>()
+                      : cfg["filepaths"].as<std::vector<std::string>>().front();
+
+  std::filesystem::path cache_dir =
+      cfg["cache_dir"]
+          ? cfg["cache_dir"].as<std::string>()
+          : env::NUISANCE_EVENT_CACHE_DIR(
+                std::filesystem::absolute(first_input).parent_path());
+
+  std::error_code ec;
+  std::filesystem::create_directories(cache_dir, ec);
+  if (ec) {
+    log_warn("Failed to create event cache directory {}: {}, events will not "
+             "be cached.",
+             cache_dir.native(), ec.message());
+    return {};
+  }
+
+  return cache_dir / fmt::format("{}.{:016x}.nuiscache.{}",
+                                 first_input.stem().native(), fingerprint,
+                                 cfg["cache_format"].as<std::string>("hepmc3"));
+}
+
+// Tees a freshly opened plugin source into the event cache, if one was
+// requested. Partial reads cannot produce a complete cache, so entry_range
+// disables writing.
+IEventSourcePtr CacheEventSource(YAML::Node const &cfg,
+                                 std::filesystem::path const &cache_path,
+                                 IEventSourcePtr es) {
+  if (cache_path.empty() || cfg["entry_range"]) {
+    return es;
+  }
+  std::filesystem::path first_input =
+      cfg["filepath"] ? cfg["filepath"].as<std::string>()
+                      : cfg["filepaths"].as<std::vector<std::string>>().front();
+  log_debug("Caching events read from source to {}", cache_path.native());
+  return std::make_shared<CachingEventSource>(
+      es, cache_path, PathPlugins::get().find(first_input));
+}
+
+// Wraps a successfully opened source in any optional wrappers requested in the
+// configuration node
+IEventSourcePtr WrapEventSource(YAML::Node const &cfg, IEventSourcePtr es) {
+  if (!es) {
+    return es;
+  }
+
+  // entry_range: [begin, end]
+  size_t range_begin = 0;
+  if (cfg["entry_range"]) {
+    auto range = cfg["entry_range"].as<std::vector<size_t>>();
+    if (range.size() != 2) {
+      log_warn("entry_range configuration key should be a two-element "
+               "sequence [begin, end], ignoring it.");
+    } else {
+      log_debug("Wrapping event source in EntryRangeEventSource: [{}, {})",
+                range[0], range[1]);
+      es = std::make_shared<EntryRangeEventSource>(es, range[0], range[1]);
+      range_begin = range[0];
     }
   }
-#endif
-  return nullptr;
+
+  // subsample: <fraction>, subsample_seed: <seed>
+  // entries are hashed by their absolute index, so that sharded and unsharded
+  // runs keep the same subsample
+  if (cfg["subsample"]) {
+    double fraction = cfg["subsample"].as<double>();
+    uint64_t seed = cfg["subsample_seed"].as<uint64_t>(0);
+    log_debug("Wrapping event source in SubsampledEventSource: fraction = {}, "
+              "seed = {}",
+              fraction, seed);
+    es = std::make_shared<SubsampledEventSource>(es, fraction, seed,
+                                                 range_begin);
+  }
+
+  size_t read_ahead_depth = ReadAheadRequested(cfg);
+  if (read_ahead_depth) {
+    log_debug("Wrapping event source in ReadAheadEventSource with queue depth "
+              "{}",
+              read_ahead_depth);
+    es = std::make_shared<ReadAheadEventSource>(es, read_ahead_depth);
+  }
+
+  return es;
 }
-#endif
 
 void EventSourceFactory::add_event_path(std::filesystem::path path) {
   if (std::filesystem::exists(path) &&
@@ -162,6 +302,59 @@ void EventSourceFactory::add_event_path(std::filesystem::path path) {
   }
 }
 
+std::pair<std::shared_ptr<HepMC3::GenRunInfo>, IEventSourcePtr>
+EventSourceFactory::try_plugins(YAML::Node const &cfg) {
+
+  bool plugin_specified = bool(cfg["plugin_name"]);
+  std::string const &plugin_name =
+      plugin_specified ? cfg["plugin_name"].as<std::string>() : "";
+
+  // probes and the remembered plugin are keyed on the first input, chained
+  // inputs are assumed to be homogeneous
+  std::filesystem::path first_input =
+      cfg["filepath"] ? cfg["filepath"].as<std::string>()
+                      : cfg["filepaths"].as<std::vector<std::string>>().front();
+
+  std::string remembered_plugin =
+      plugin_specified ? std::string() : PathPlugins::get().find(first_input);
+
+  // try the plugin that last opened this input first, then the rest
+  std::vector<EventInputPlugin const *> candidates;
+  for (auto const &plugin : plugins) {
+    if (plugin.name == remembered_plugin) {
+      candidates.insert(candidates.begin(), &plugin);
+    } else {
+      candidates.push_back(&plugin);
+    }
+  }
+
+  for (auto const plugin : candidates) {
+    if (plugin_specified) {
+      if (plugin->name != plugin_name) {
+        continue;
+      }
+    } else if ((plugin->name != remembered_plugin) &&
+               !plugin->can_read(first_input)) {
+      log_trace("Plugin {} cannot read file {}", plugin->name,
+                first_input.native());
+      continue;
+    }
+
+    log_trace("Trying plugin {} for file {}", plugin->name,
+              first_input.native());
+    auto es = plugin->make(cfg);
+    auto ev = es->first();
+    if (ev) {
+      log_debug("Plugin {} is able to read file", plugin->name);
+      PathPlugins::get().set(first_input, plugin->name);
+      return {ev->run_info(), es};
+    }
+  }
+
+  PathPlugins::get().erase(first_input);
+  return {nullptr, nullptr};
+}
+
 std::pair<std::shared_ptr<HepMC3::GenRunInfo>, IEventSourcePtr>
 EventSourceFactory::make_unnormalized(YAML::Node cfg) {
 
@@ -197,48 +390,73 @@ EventSourceFactory::make_unnormalized(YAML::Node cfg) {
     return {nullptr, nullptr};
   }
 
-#ifdef NUISANCE_USE_BOOSTDLL
-  for (auto &[pluginso, plugin] : pluginfactories) {
-    log_trace("Trying plugin {} for file {}", pluginso.native(),
-              bool(cfg["filepath"])
-                  ? fmt::format("{}", cfg["filepath"].as<std::string>())
-                  : fmt::format(
-                        "{}", cfg["filepaths"].as<std::vector<std::string>>()));
-    auto es = plugin(cfg);
-    if (es->first()) {
-      log_debug("Plugin {} is able to read file", pluginso.native());
-      return {es->first()->run_info(), es};
+  if (ReadAheadRequested(cfg)) {
+    // plugins will be driven from a thread other than the caller's
+    cfg["thread_safe"] = true;
+  }
+
+  bool recycle_events =
+      cfg["recycle_events"] && cfg["recycle_events"].as<bool>();
+  if (recycle_events && !cfg["recycle_pool_size"]) {
+    // events queued by a read-ahead thread are still referenced, so the pool
+    // has to cover the whole queue before anything can be recycled
+    cfg["recycle_pool_size"] =
+        GenEventPool::default_pool_size + ReadAheadRequested(cfg);
+  }
+  size_t recycle_pool_size = cfg["recycle_pool_size"].as<size_t>(
+      GenEventPool::default_pool_size);
+  size_t parse_threads = cfg["parallel_parse_threads"]
+                             ? cfg["parallel_parse_threads"].as<size_t>()
+                             : 0;
+
+  auto cache_path = EventCachePath(cfg);
+  if (!cache_path.empty() && std::filesystem::exists(cache_path)) {
+    auto es = std::make_shared<HepMC3EventSource>(
+        cache_path, recycle_events, parse_threads, recycle_pool_size);
+    auto ev = es->first();
+    if (ev) {
+      log_info("Reading events for {} from cache {}",
+               bool(cfg["filepath"])
+                   ? fmt::format("{}", cfg["filepath"].as<std::string>())
+                   : fmt::format(
+                         "{}", cfg["filepaths"].as<std::vector<std::string>>()),
+               cache_path.native());
+      return {ev->run_info(), WrapEventSource(cfg, es)};
     }
+    log_warn("Failed to read event cache {}, it will be regenerated.",
+             cache_path.native());
   }
-#else
+
   log_trace("Trying all known EventInput plugins...");
-  auto esp = TryAllKnownEventInputPlugins(cfg);
+  auto [gri, esp] = try_plugins(cfg);
   if (esp) {
-    log_trace("Found a plugin!");
-    return {esp->first()->run_info(), esp};
+    return {gri, WrapEventSource(cfg, CacheEventSource(cfg, cache_path, esp))};
   }
   log_trace("Found no plugins capable of reading file.");
-#endif
 
-  if (!cfg["filepath"]) {
-    log_warn("[make_unnormalized] was only passed a filepaths attribute, "
-             "but no plugin was able to read the files. N.B. When reading "
-             "HepMC3 files, they must be passed individually via the "
-             "filepath attribute as HepMC3 has no equivalent of a TChain.");
-    return {nullptr, nullptr};
+  // HepMC3 files passed via filepaths are read as one chained stream
+  std::vector<std::filesystem::path> hepmc3_paths;
+  if (cfg["filepath"]) {
+    hepmc3_paths.push_back(cfg["filepath"].as<std::string>());
+  } else {
+    for (auto const &f : cfg["filepaths"].as<std::vector<std::string>>()) {
+      hepmc3_paths.push_back(f);
+    }
   }
 
   // try plugins first as there is a bug in HepMC3 root reader that segfaults
   // if it is not passed the expected type.
-  auto es =
-      std::make_shared<HepMC3EventSource>(cfg["filepath"].as<std::string>());
-  if (es->first()) {
-    log_debug("Reading file {} with native HepMC3EventSource",
-              cfg["filepath"].as<std::string>());
-    return {es->first()->run_info(), es};
+  auto es = std::make_shared<HepMC3EventSource>(
+      hepmc3_paths, recycle_events, parse_threads, recycle_pool_size);
+  auto ev = es->first();
+  if (ev) {
+    log_debug("Reading {} file(s) with native HepMC3EventSource, first: {}",
+              hepmc3_paths.size(), hepmc3_paths.front().native());
+    return {ev->run_info(),
+            WrapEventSource(cfg, CacheEventSource(cfg, cache_path, es))};
   }
   log_warn("Failed to find plugin capable of reading input file: {}.",
-           cfg["filepath"].as<std::string>());
+           hepmc3_paths.front().native());
   return {nullptr, nullptr};
 }
 
@@ -252,12 +470,92 @@ EventSourceFactory::make_unnormalized(std::string const &filepath) {
 std::pair<std::shared_ptr<HepMC3::GenRunInfo>, NormalizedEventSourcePtr>
 EventSourceFactory::make(YAML::Node const &cfg) {
   auto [gri, es] = make_unnormalized(cfg);
-  auto nes = std::make_shared<NormalizedEventSource>(es);
+  NormalizedEventSourcePtr nes = std::make_shared<NormalizedEventSource>(es);
+
+  // unweight: <max_weight>, unweight_seed: <seed>
+  if (cfg["unweight"]) {
+    double max_weight = cfg["unweight"].as<double>();
+    uint64_t seed = cfg["unweight_seed"].as<uint64_t>(0);
+    log_debug("Unweighting event source: max_weight = {}, seed = {}",
+              max_weight, seed);
+    nes = std::make_shared<UnweightedNormalizedEventSource>(nes, max_weight,
+                                                            seed);
+  }
+
   if (nes->first()) {
     return {gri, nes};
   }
   return {nullptr, nullptr};
 }
+std::pair<std::shared_ptr<HepMC3::GenRunInfo>, NormalizedEventSourcePtr>
+EventSourceFactory::make_indexed(
+    YAML::Node const &cfg, std::string const &selection_name,
+    std::function<int(HepMC3::GenEvent const &)> const &sel,
+    bool store_weights) {
+
+  // entries are read directly from the underlying source, the wrappers that
+  // select or reorder entries were already applied when the index was built
+  YAML::Node read_cfg = YAML::Clone(cfg);
+  for (auto const &key :
+       {"entry_range", "subsample", "subsample_seed", "read_ahead", "cache",
+        "unweight", "unweight_seed"}) {
+    read_cfg.remove(key);
+  }
+  auto [gri, es] = make_unnormalized(read_cfg);
+  if (!es) {
+    return {nullptr, nullptr};
+  }
+  // check before building the index so that a non-seekable input is only read
+  // once
+  if (!es->seekable()) {
+    log_warn("The inputs for event index {} are not seekable, reading all "
+             "events instead.",
+             selection_name);
+    return make(YAML::Clone(cfg));
+  }
+
+  auto index_path = EventIndexPath(cfg, selection_name);
+  std::optional<EventIndex> index;
+  if (!index_path.empty() && std::filesystem::exists(index_path)) {
+    index = EventIndex::read(index_path);
+    if (index && !index->matches(*es)) {
+      log_warn("Event index {} does not match its inputs, rebuilding it.",
+               index_path.native());
+      index.reset();
+    }
+  }
+
+  if (!index) {
+    // the index is of the weighted inputs, unweighting is not reproducible
+    // from a subset of the events
+    YAML::Node build_cfg = YAML::Clone(cfg);
+    build_cfg.remove("unweight");
+    build_cfg.remove("unweight_seed");
+    auto [build_gri, evs] = make(build_cfg);
+    if (!evs) {
+      return {nullptr, nullptr};
+    }
+    index = BuildEventIndex(evs, es, sel, store_weights);
+    if (!index) {
+      log_warn("Cannot index the inputs for selection {}, reading all events "
+               "instead.",
+               selection_name);
+      return make(YAML::Clone(cfg));
+    }
+    if (!index_path.empty() && index->write(index_path)) {
+      log_info("Wrote event index for selection {} to {}", selection_name,
+               index_path.native());
+    }
+  } else {
+    log_info("Read event index for selection {} from {}", selection_name,
+             index_path.native());
+  }
+
+  return {gri, std::make_shared<IndexedNormalizedEventSource>(
+                   es, std::make_shared<EventIndex const>(
+                           std::move(index.value())))};
+}
+
 std::pair<std::shared_ptr<HepMC3::GenRunInfo>, NormalizedEventSourcePtr>
 EventSourceFactory::make(std::string const &filepath) {
   return make(YAML::Load(fmt::format(R"(
@@ -2,19 +2,17 @@
 
 #include "nuis/eventinput/NormalizedEventSource.h"
 
-#ifdef NUISANCE_USE_BOOSTDLL
-#include "boost/function.hpp"
-#endif
-
 #include "nuis/log.h"
 
 #include "yaml-cpp/yaml.h"
 
 #include <filesystem>
+#include <functional>
 #include <vector>
 
 namespace HepMC3 {
 class GenRunInfo;
+class GenEvent;
 }
 
 namespace nuis {
@@ -28,11 +26,16 @@ struct PathResolver : public nuis_named_log("EventInput") {
 class EventSourceFactory : public nuis_named_log("EventInput") {
   PathResolver resolv;
 
-#ifdef NUISANCE_USE_BOOSTDLL
-  using IEventSource_PluginFactory_t = IEventSourcePtr(YAML::Node const &);
-  std::map<std::filesystem::path, boost::function<IEventSource_PluginFactory_t>>
-      pluginfactories;
-#endif
+  struct EventInputPlugin {
+    std::string name;
+    // cheap probe that must not fully open the source
+    std::function<bool(std::filesystem::path const &)> can_read;
+    std::function<IEventSourcePtr(YAML::Node const &)> make;
+  };
+  std::vector<EventInputPlugin> plugins;
+
+  std::pair<std::shared_ptr<HepMC3::GenRunInfo>, IEventSourcePtr>
+  try_plugins(YAML::Node const &cfg);
 
 public:
   EventSourceFactory();
@@ -45,6 +48,15 @@ public:
   std::pair<std::shared_ptr<HepMC3::GenRunInfo>, NormalizedEventSourcePtr>
   make(std::string const &filepath);
 
+  // Reads only the events that pass sel, using the persistent EventIndex for
+  // selection_name on these inputs, which is built and written on first use.
+  // Falls back to make(cfg) if the inputs are not seekable, so callers must
+  // still apply their selection.
+  std::pair<std::shared_ptr<HepMC3::GenRunInfo>, NormalizedEventSourcePtr>
+  make_indexed(YAML::Node const &cfg, std::string const &selection_name,
+               std::function<int(HepMC3::GenEvent const &)> const &sel,
+               bool store_weights = true);
+
   std::pair<std::shared_ptr<HepMC3::GenRunInfo>, IEventSourcePtr>
   make_unnormalized(YAML::Node cfg);
   std::pair<std::shared_ptr<HepMC3::GenRunInfo>, IEventSourcePtr>
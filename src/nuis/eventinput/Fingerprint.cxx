@@ -0,0 +1,85 @@
+#include "nuis/eventinput/Fingerprint.h"
+
+#include "fmt/core.h"
+
+#include <array>
+#include <fstream>
+#include <vector>
+
+namespace nuis {
+
+uint64_t StableHash(std::string const &str, uint64_t seed) {
+  uint64_t hash = seed;
+  for (unsigned char c : str) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::string FileFingerprint(std::filesystem::path const &path) {
+  std::error_code ec;
+  auto abspath = std::filesystem::absolute(path, ec);
+  if (ec || !std::filesystem::exists(abspath)) {
+    return "";
+  }
+
+  auto fsize = std::filesystem::file_size(abspath, ec);
+  auto mtime = std::filesystem::last_write_time(abspath, ec);
+  if (ec) {
+    return "";
+  }
+
+  constexpr size_t const block_size = 64 * 1024;
+  std::string block(block_size, '\0');
+
+  std::ifstream fin(abspath, std::ios::binary);
+  fin.read(block.data(), block_size);
+  uint64_t hash = StableHash(block.substr(0, fin.gcount()));
+
+  if (fsize > block_size) {
+    fin.clear();
+    fin.seekg(fsize - block_size);
+    fin.read(block.data(), block_size);
+    hash = StableHash(block.substr(0, fin.gcount()), hash);
+  }
+
+  return fmt::format("{}:{}:{}:{:016x}", abspath.native(), fsize,
+                     mtime.time_since_epoch().count(), hash);
+}
+
+uint64_t EventSourceFingerprint(YAML::Node const &cfg) {
+  static std::array<std::string, 18> const delivery_keys = {
+      "filepath",       "filepaths",      "read_ahead",
+      "thread_safe",    "entry_range",    "recycle_events",
+      "recycle_pool_size",
+      "cache",          "cache_dir",      "cache_format",
+      "subsample",      "subsample_seed", "unweight",
+      "unweight_seed",  "parallel_parse_threads",
+      "spline_cache",   "spline_cache_dir",
+      "index_dir"};
+
+  YAML::Node content_cfg = YAML::Clone(cfg);
+  for (auto const &key : delivery_keys) {
+    content_cfg.remove(key);
+  }
+
+  std::vector<std::string> filepaths;
+  if (cfg["filepath"]) {
+    filepaths.push_back(cfg["filepath"].as<std::string>());
+  } else if (cfg["filepaths"]) {
+    filepaths = cfg["filepaths"].as<std::vector<std::string>>();
+  }
+
+  uint64_t hash = StableHash(YAML::Dump(content_cfg));
+  for (auto const &fp : filepaths) {
+    auto ffp = FileFingerprint(fp);
+    if (!ffp.size()) {
+      return 0;
+    }
+    hash = StableHash(ffp, hash);
+  }
+  return hash;
+}
+
+} // namespace nuis
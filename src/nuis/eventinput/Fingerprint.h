@@ -0,0 +1,27 @@
+#pragma once
+
+#include "yaml-cpp/yaml.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace nuis {
+
+// FNV-1a, stable across platforms and runs unlike std::hash
+uint64_t StableHash(std::string const &str,
+                    uint64_t seed = 14695981039346656037ULL);
+
+// A cheap content fingerprint of a file: its absolute path, size, last
+// modification time and a hash of the first and last 64 KiB. Returns an empty
+// string if the file does not exist.
+std::string FileFingerprint(std::filesystem::path const &path);
+
+// Fingerprints an EventSourceFactory configuration node by the content of its
+// input files and the keys that change the events a plugin produces. Keys that
+// only change how events are delivered (read_ahead, entry_range, cache, ...)
+// are ignored. Returns 0 if any input file cannot be fingerprinted, e.g. a
+// remote file.
+uint64_t EventSourceFingerprint(YAML::Node const &cfg);
+
+} // namespace nuis
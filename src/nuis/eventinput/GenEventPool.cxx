@@ -0,0 +1,101 @@
+#include "nuis/eventinput/GenEventPool.h"
+
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenVertex.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace nuis {
+
+namespace {
+// minimal allocator over a shared memory resource. We cannot use
+// std::pmr::polymorphic_allocator as it only holds a raw pointer to the
+// resource, which would dangle if a particle outlived its pool.
+template <typename T> struct SharedResourceAllocator {
+  using value_type = T;
+
+  std::shared_ptr<std::pmr::memory_resource> resource;
+
+  SharedResourceAllocator(std::shared_ptr<std::pmr::memory_resource> r)
+      : resource(std::move(r)) {}
+  template <typename U>
+  SharedResourceAllocator(SharedResourceAllocator<U> const &other)
+      : resource(other.resource) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(resource->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *p, size_t n) {
+    resource->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  template <typename U>
+  bool operator==(SharedResourceAllocator<U> const &other) const {
+    return resource == other.resource;
+  }
+  template <typename U>
+  bool operator!=(SharedResourceAllocator<U> const &other) const {
+    return resource != other.resource;
+  }
+};
+} // namespace
+
+GenEventPool::GenEventPool(bool recycle_events, size_t pool_size)
+    : recycle{recycle_events}, next_slot{0} {
+  if (recycle) {
+    events.resize(std::max(pool_size, size_t(1)));
+    // synchronized as events may be released on a different thread to the one
+    // filling them, e.g. behind a ReadAheadEventSource
+    resource = std::make_shared<std::pmr::synchronized_pool_resource>();
+  }
+}
+
+std::shared_ptr<HepMC3::GenEvent>
+GenEventPool::event(HepMC3::Units::MomentumUnit mu,
+                    HepMC3::Units::LengthUnit lu) {
+  if (!recycle) {
+    return std::make_shared<HepMC3::GenEvent>(mu, lu);
+  }
+
+  for (size_t i = 0; i < events.size(); ++i) {
+    auto &slot = events[(next_slot + i) % events.size()];
+    if (!slot) {
+      slot = std::make_shared<HepMC3::GenEvent>(mu, lu);
+    } else if (slot.use_count() == 1) {
+      // pair with the release of the last external reference
+      std::atomic_thread_fence(std::memory_order_acquire);
+      slot->clear();
+      slot->set_units(mu, lu);
+    } else {
+      continue;
+    }
+    next_slot = (next_slot + i + 1) % events.size();
+    return slot;
+  }
+
+  // everything is still in use downstream
+  return std::make_shared<HepMC3::GenEvent>(mu, lu);
+}
+
+std::shared_ptr<HepMC3::GenParticle>
+GenEventPool::particle(HepMC3::FourVector const &mom, int pid, int status) {
+  if (!recycle) {
+    return std::make_shared<HepMC3::GenParticle>(mom, pid, status);
+  }
+  return std::allocate_shared<HepMC3::GenParticle>(
+      SharedResourceAllocator<HepMC3::GenParticle>(resource), mom, pid,
+      status);
+}
+
+std::shared_ptr<HepMC3::GenVertex>
+GenEventPool::vertex(HepMC3::FourVector const &pos) {
+  if (!recycle) {
+    return std::make_shared<HepMC3::GenVertex>(pos);
+  }
+  return std::allocate_shared<HepMC3::GenVertex>(
+      SharedResourceAllocator<HepMC3::GenVertex>(resource), pos);
+}
+
+} // namespace nuis
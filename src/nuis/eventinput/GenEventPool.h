@@ -0,0 +1,62 @@
+#pragma once
+
+#include "HepMC3/FourVector.h"
+#include "HepMC3/Units.h"
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace HepMC3 {
+class GenEvent;
+class GenParticle;
+class GenVertex;
+} // namespace HepMC3
+
+namespace nuis {
+
+/// Recycles HepMC3::GenEvent instances between calls to IEventSource::next and
+/// carves the particles and vertices built by event converters out of a pooled
+/// memory resource. Recycling is opt-in, when it is disabled the pool simply
+/// forwards to std::make_shared.
+///
+/// An event is only reused once the pool holds the last reference to it, so the
+/// pool must have more slots than the number of events that callers hold at
+/// once, e.g. a read-ahead queue or a batch, or every event is freshly
+/// allocated. EventSourceFactory sizes it from the read-ahead depth, the
+/// recycle_pool_size configuration key overrides this.
+/// N.B. When recycling, particles and vertices must not be used after their
+/// parent event has been released, as the event object they point back to may
+/// have been refilled.
+class GenEventPool {
+
+  bool recycle;
+  size_t next_slot;
+  std::vector<std::shared_ptr<HepMC3::GenEvent>> events;
+
+  // shared with every particle and vertex allocated from it so that it
+  // outlives them
+  std::shared_ptr<std::pmr::memory_resource> resource;
+
+public:
+  constexpr static size_t const default_pool_size = 4;
+
+  GenEventPool(bool recycle_events = false,
+               size_t pool_size = default_pool_size);
+
+  bool recycling() const { return recycle; }
+
+  // Returns an empty event, which will be a recycled one if one is available
+  std::shared_ptr<HepMC3::GenEvent>
+  event(HepMC3::Units::MomentumUnit mu = HepMC3::Units::GEV,
+        HepMC3::Units::LengthUnit lu = HepMC3::Units::MM);
+
+  std::shared_ptr<HepMC3::GenParticle>
+  particle(HepMC3::FourVector const &mom = HepMC3::FourVector::ZERO_VECTOR(),
+           int pid = 0, int status = 0);
+
+  std::shared_ptr<HepMC3::GenVertex>
+  vertex(HepMC3::FourVector const &pos = HepMC3::FourVector::ZERO_VECTOR());
+};
+
+} // namespace nuis
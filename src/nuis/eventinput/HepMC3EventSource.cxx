@@ -1,4 +1,5 @@
 #include "nuis/eventinput/HepMC3EventSource.h"
+#include "nuis/eventinput/ParallelHepMC3AsciiReader.h"
 
 // this is required to enable gzip reading if we built in the support
 #include "NuHepMC/HepMC3Features.hxx"
@@ -7,62 +8,186 @@
 #include "nuis/log.txx"
 
 #include <fstream>
+#include <limits>
 
 namespace nuis {
 
-HepMC3EventSource::HepMC3EventSource(std::filesystem::path const &fp)
-    : filepath(fp) {};
+HepMC3EventSource::HepMC3EventSource(std::filesystem::path const &fp,
+                                     bool recycle_events,
+                                     size_t nparse_threads,
+                                     size_t recycle_pool_size)
+    : HepMC3EventSource(std::vector<std::filesystem::path>{fp},
+                        recycle_events, nparse_threads, recycle_pool_size) {}
 
-std::shared_ptr<HepMC3::GenEvent> HepMC3EventSource::first() {
+HepMC3EventSource::HepMC3EventSource(
+    std::vector<std::filesystem::path> const &fps, bool recycle_events,
+    size_t nparse_threads, size_t recycle_pool_size)
+    : filepaths(fps), parse_threads{nparse_threads}, file_it{0},
+      pool(recycle_events, recycle_pool_size), at_first{false} {};
+
+HepMC3EventSource::FileReader
+HepMC3EventSource::open_file(std::filesystem::path const &fp) {
 
   // refuse to read ROOT files as the reader has a bug in it
-  if (!std::filesystem::exists(filepath)) {
-    log_warn("HepMC3EventSource ignoring non-existant path {}",
-             filepath.native());
-    return nullptr;
+  if (!std::filesystem::exists(fp)) {
+    log_warn("HepMC3EventSource ignoring non-existant path {}", fp.native());
+    return FileReader{};
   }
-  std::ifstream fin(filepath);
+  std::ifstream fin(fp);
   char magicbytes[5];
   fin.read(magicbytes, 4);
   magicbytes[4] = '\0';
   if (std::string(magicbytes) == "root") {
-    log_warn("HepMC3EventSource ignoring ROOT file {}", filepath.native(),
+    log_warn("HepMC3EventSource ignoring ROOT file {}", fp.native(),
              magicbytes);
-    return nullptr;
+    return FileReader{};
+  }
+
+  if (parse_threads) {
+    auto parallel_reader =
+        std::make_shared<ParallelHepMC3AsciiReader>(fp, parse_threads);
+    if (parallel_reader->good()) {
+      log_debug("HepMC3EventSource parsing {} with {} threads.", fp.native(),
+                parse_threads);
+      return FileReader{nullptr, parallel_reader};
+    }
+    log_debug("HepMC3EventSource cannot parse {} in parallel as it is not a "
+              "HepMC3 ASCII file.",
+              fp.native());
   }
 
-  // reopen the file from the start and get the next event
-  reader = std::make_unique<NuHepMC::Reader>(filepath);
+  std::shared_ptr<HepMC3::Reader> reader =
+      std::make_unique<NuHepMC::Reader>(fp);
   if (!reader || reader->failed()) {
     log_warn("Couldn't deduce reader for {} reader = {}, failed {}",
-             filepath.native(), bool(reader),
-             reader ? reader->failed() : false);
-    return nullptr;
+             fp.native(), bool(reader), reader ? reader->failed() : false);
+    return FileReader{};
   }
   NUIS_LOG_TRACE("Successfully opened {} with HepMC3EventSource",
-                 filepath.native());
-  return next();
+                 fp.native());
+  return FileReader{reader, nullptr};
 }
 
-std::shared_ptr<HepMC3::GenEvent> HepMC3EventSource::next() {
-  if (reader->failed()) {
-    NUIS_LOG_TRACE("HepMC3EventSource::next reader started in failed state.");
+void HepMC3EventSource::prefetch(size_t file_idx) {
+  if (file_idx >= filepaths.size()) {
+    next_file = std::future<FileReader>();
+    return;
+  }
+  next_file = std::async(std::launch::async, [this, file_idx]() {
+    return open_file(filepaths[file_idx]);
+  });
+}
+
+bool HepMC3EventSource::advance_file() {
+  while ((file_it + 1) < filepaths.size()) {
+    file_it++;
+    current = next_file.valid() ? next_file.get()
+                                : open_file(filepaths[file_it]);
+    prefetch(file_it + 1);
+    if (current) {
+      log_debug("HepMC3EventSource moved on to file {}/{}: {}", file_it + 1,
+                filepaths.size(), filepaths[file_it].native());
+      return true;
+    }
+    log_warn("HepMC3EventSource skipping unreadable file {}",
+             filepaths[file_it].native());
+  }
+  current = FileReader{};
+  return false;
+}
+
+std::shared_ptr<HepMC3::GenEvent> HepMC3EventSource::read_current() {
+  std::shared_ptr<HepMC3::GenEvent> evt;
+  if (current.parallel_reader) {
+    evt = current.parallel_reader->next();
+  } else if (current.reader) {
+    if (current.reader->failed()) {
+      NUIS_LOG_TRACE(
+          "HepMC3EventSource::next reader started in failed state.");
+      return nullptr;
+    }
+    evt = pool.event();
+    current.reader->read_event(*evt);
+    if (current.reader->failed()) {
+      NUIS_LOG_TRACE(
+          "HepMC3EventSource::next reader was failed after reading event.");
+      return nullptr;
+    }
+  }
+
+  if (evt) {
+    evt->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
+  }
+  return evt;
+}
+
+std::shared_ptr<HepMC3::GenEvent> HepMC3EventSource::first() {
+
+  if (at_first) {
+    return first_event;
+  }
+
+  // reopen the files from the start and get the next event
+  current = FileReader{};
+  if (next_file.valid()) {
+    next_file.wait();
+  }
+  next_file = std::future<FileReader>();
+
+  if (!filepaths.size()) {
     return nullptr;
   }
 
-  auto evt = std::make_shared<HepMC3::GenEvent>();
-  reader->read_event(*evt);
-  if (reader->failed()) {
-    NUIS_LOG_TRACE(
-        "HepMC3EventSource::next reader was failed after reading event.");
+  // one before the first file, so that advance_file() opens the first file
+  // and skips it if it is unreadable, like any other file. file_it + 1 wraps
+  // to 0.
+  file_it = std::numeric_limits<size_t>::max();
+  if (!advance_file()) {
     return nullptr;
   }
 
-  evt->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
-  NUIS_LOG_TRACE("HepMC3EventSource::next returning event: {}", evt->event_number());
+  first_event = next();
+  at_first = bool(first_event);
+  return first_event;
+}
+
+std::shared_ptr<HepMC3::GenEvent> HepMC3EventSource::next() {
+  at_first = false;
+  first_event.reset();
+
+  auto evt = read_current();
+  while (!evt && current && advance_file()) {
+    evt = read_current();
+  }
+
+  if (evt) {
+    NUIS_LOG_TRACE("HepMC3EventSource::next returning event: {}",
+                   evt->event_number());
+  }
   return evt;
 }
 
+size_t HepMC3EventSource::next_batch(
+    std::vector<std::shared_ptr<HepMC3::GenEvent>> &batch, size_t n) {
+  at_first = false;
+  first_event.reset();
+  batch.clear();
+
+  while (batch.size() < n) {
+    auto evt = read_current();
+    if (!evt) {
+      if (current && advance_file()) {
+        continue;
+      }
+      break;
+    }
+    batch.push_back(std::move(evt));
+  }
+  NUIS_LOG_TRACE("HepMC3EventSource::next_batch returning {} events.",
+                 batch.size());
+  return batch.size();
+}
+
 HepMC3EventSource::~HepMC3EventSource() {}
 
 } // namespace nuis
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "nuis/eventinput/GenEventPool.h"
 #include "nuis/eventinput/IEventSource.h"
 
 #include <filesystem>
+#include <future>
+#include <vector>
 
 namespace HepMC3 {
 class Reader;
@@ -10,16 +13,59 @@ class Reader;
 
 namespace nuis {
 
+class ParallelHepMC3AsciiReader;
+
+/// Reads one or more HepMC3/NuHepMC files as a single event stream. Only the
+/// current file is open, the next one is opened in the background so that
+/// file boundaries do not stall the event loop.
 class HepMC3EventSource : public IEventSource {
 
-  std::filesystem::path filepath;
-  std::shared_ptr<HepMC3::Reader> reader;
+  std::vector<std::filesystem::path> filepaths;
+
+  // if parse_threads > 0, ASCII inputs are inflated and parsed off the calling
+  // thread by a ParallelHepMC3AsciiReader, other formats use reader
+  size_t parse_threads;
+
+  struct FileReader {
+    std::shared_ptr<HepMC3::Reader> reader;
+    std::shared_ptr<ParallelHepMC3AsciiReader> parallel_reader;
+
+    operator bool() const { return reader || parallel_reader; }
+  };
+
+  FileReader open_file(std::filesystem::path const &fp);
+
+  size_t file_it;
+  FileReader current;
+  std::future<FileReader> next_file;
+
+  void prefetch(size_t file_idx);
+  // moves on to the next file that can be opened, false if there are none
+  bool advance_file();
+  // nullptr when the current file is exhausted
+  std::shared_ptr<HepMC3::GenEvent> read_current();
+
+  GenEventPool pool;
+
+  // HepMC3 readers cannot rewind, so the first event is kept to make repeated
+  // calls to first() without an intervening next() free
+  std::shared_ptr<HepMC3::GenEvent> first_event;
+  bool at_first;
 
 public:
-  HepMC3EventSource(std::filesystem::path const &fp);
+  HepMC3EventSource(
+      std::filesystem::path const &fp, bool recycle_events = false,
+      size_t parse_threads = 0,
+      size_t recycle_pool_size = GenEventPool::default_pool_size);
+  HepMC3EventSource(
+      std::vector<std::filesystem::path> const &fps,
+      bool recycle_events = false, size_t parse_threads = 0,
+      size_t recycle_pool_size = GenEventPool::default_pool_size);
 
   std::shared_ptr<HepMC3::GenEvent> first();
   std::shared_ptr<HepMC3::GenEvent> next();
+  size_t next_batch(std::vector<std::shared_ptr<HepMC3::GenEvent>> &batch,
+                    size_t n);
 
   virtual ~HepMC3EventSource();
 };
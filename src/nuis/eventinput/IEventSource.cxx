@@ -1,8 +1,78 @@
 #include "nuis/eventinput/IEventSource.h"
 #include "nuis/eventinput/NormalizedEventSource.h"
 
+#include "nuis/except.h"
+
+#include "NuHepMC/EventUtils.hxx"
+#include "NuHepMC/ReaderUtils.hxx"
+
+#include "HepMC3/Attribute.h"
+#include "HepMC3/GenParticle.h"
+
 namespace nuis {
 
+DECLARE_NUISANCE_EXCEPT(EventSourceNotSeekable);
+
+EventHeader GetEventHeader(HepMC3::GenEvent const &ev) {
+  EventHeader hdr{0, 0, 0, 0, 0};
+  hdr.process_id = NuHepMC::ER3::ReadProcessID(ev);
+
+  auto beam = NuHepMC::Event::GetBeamParticle(ev);
+  if (beam) {
+    hdr.probe_pdg = beam->pid();
+    hdr.probe_energy = beam->momentum().e();
+  }
+
+  auto tgt = NuHepMC::Event::GetTargetParticle(ev);
+  if (tgt) {
+    hdr.target_pdg = tgt->pid();
+  }
+  return hdr;
+}
+
+std::shared_ptr<HepMC3::GenEvent>
+MakePrefilteredStub(std::shared_ptr<HepMC3::GenRunInfo> gri,
+                    int event_number) {
+  // weights are initialized to 1 for every weight name in the run info
+  auto ev = std::make_shared<HepMC3::GenEvent>(gri, HepMC3::Units::MEV,
+                                               HepMC3::Units::CM);
+  ev->set_event_number(event_number);
+  ev->add_attribute(PrefilteredStubAttribute,
+                    std::make_shared<HepMC3::IntAttribute>(1));
+  return ev;
+}
+
+bool IsPrefilteredStub(HepMC3::GenEvent const &ev) {
+  auto stub = ev.attribute<HepMC3::IntAttribute>(PrefilteredStubAttribute);
+  return stub && stub->value();
+}
+
+bool IEventSource::seek(size_t) {
+  throw EventSourceNotSeekable()
+      << "seek called on an event source that does not support random access.";
+}
+
+std::shared_ptr<HepMC3::GenEvent> IEventSource::read(size_t entry) {
+  if (!seek(entry)) {
+    return nullptr;
+  }
+  return next();
+}
+
+size_t
+IEventSource::next_batch(std::vector<std::shared_ptr<HepMC3::GenEvent>> &batch,
+                         size_t n) {
+  batch.clear();
+  while (batch.size() < n) {
+    auto ev = next();
+    if (!ev) {
+      break;
+    }
+    batch.push_back(std::move(ev));
+  }
+  return batch.size();
+}
+
 NormalizedEventSourcePtr
 IEventSource::force_fatx(double fatx,
                          NuHepMC::CrossSection::Units::Unit const &units) {
@@ -4,18 +4,82 @@
 
 #include "nuis/log.h"
 
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace HepMC3 {
+class GenRunInfo;
+}
+
 namespace NuHepMC::CrossSection::Units {
 struct Unit;
 } // namespace NuHepMC::CrossSection::Units
 
 namespace nuis {
 
+// A cheap summary of an entry that sources can read from their native record
+// before building a HepMC3::GenEvent. Fields that a source cannot fill cheaply
+// are left as 0, predicates should not reject on them.
+struct EventHeader {
+  // NuHepMC E.R.3 process id
+  int process_id;
+  // generator-native channel code, e.g. the NEUT mode
+  int native_mode;
+  int probe_pdg;
+  // MeV
+  double probe_energy;
+  int target_pdg;
+};
+
+using EventHeaderFilterFunc = std::function<bool(EventHeader const &)>;
+
+// Builds the header for an already-converted event, native_mode is always 0
+EventHeader GetEventHeader(HepMC3::GenEvent const &ev);
+
+// Entries rejected by a prefilter are returned as stub events that carry the
+// run info, event number and weights (and any per-event cross-section
+// information needed for normalization), but no particles. Stubs are marked
+// with the PrefilteredStubAttribute event attribute, events that merely have
+// no particles are not stubs.
+inline std::string const PrefilteredStubAttribute = "NUISANCE.Prefiltered";
+std::shared_ptr<HepMC3::GenEvent>
+MakePrefilteredStub(std::shared_ptr<HepMC3::GenRunInfo> gri, int event_number);
+bool IsPrefilteredStub(HepMC3::GenEvent const &ev);
+
 class IEventSource : public std::enable_shared_from_this<IEventSource>,
                      public nuis_named_log("EventInput") {
 public:
   virtual std::shared_ptr<HepMC3::GenEvent> first() = 0;
   virtual std::shared_ptr<HepMC3::GenEvent> next() = 0;
 
+  // Optional random access. Sources that support it override seekable(),
+  // size() and seek(), entry counts are only valid after first() has been
+  // called.
+  virtual bool seekable() { return false; }
+  // Number of entries in the source, 0 if not known
+  virtual size_t size() { return 0; }
+  // Positions the source so that the next call to next() returns entry, does
+  // not decode any events. Returns false if entry is out of range.
+  virtual bool seek(size_t entry);
+  // Returns the event at entry and leaves the source positioned so that
+  // next() returns entry + 1
+  virtual std::shared_ptr<HepMC3::GenEvent> read(size_t entry);
+
+  // Clears batch and fills it with up to n events, continuing from where the
+  // last call to first(), next() or next_batch() left off. Returns the number
+  // of events read, 0 when the source is exhausted. The default implementation
+  // calls next() n times, sources that can do better should override it.
+  virtual size_t
+  next_batch(std::vector<std::shared_ptr<HepMC3::GenEvent>> &batch, size_t n);
+
+  // Filter pushdown. Sources that can read an EventHeader from their native
+  // record evaluate filt before building each event and return a prefiltered
+  // stub for rejected entries. Returns false if the source does not support
+  // pushdown, in which case nothing is installed. Should be called before
+  // first(), an empty filt removes the prefilter.
+  virtual bool set_prefilter(EventHeaderFilterFunc) { return false; }
+
   // Allows you to force the flux-averaged total cross section
   NormalizedEventSourcePtr force_fatx(
       double fatx, NuHepMC::CrossSection::Units::Unit const &units);
@@ -8,6 +8,10 @@ IEventSourceWrapper::IEventSourceWrapper(std::shared_ptr<IEventSource> evs)
     : wrapped_ev_source(evs) {}
 
 std::shared_ptr<IEventSource> IEventSourceWrapper::unwrap() {
+  auto inner = std::dynamic_pointer_cast<IEventSourceWrapper>(wrapped_ev_source);
+  if (inner) {
+    return inner->unwrap();
+  }
   return wrapped_ev_source;
 }
 
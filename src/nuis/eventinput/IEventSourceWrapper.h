@@ -18,9 +18,11 @@ public:
   IEventSourceWrapper(std::shared_ptr<IEventSource> evs);
 
   template <typename T> std::shared_ptr<T> as() {
-    return std::dynamic_pointer_cast<T>(wrapped_ev_source);
+    return std::dynamic_pointer_cast<T>(unwrap());
   }
 
+  // Returns the lowest level event source, looking through any intermediate
+  // wrappers that are themselves IEventSources (e.g. ReadAheadEventSource)
   std::shared_ptr<IEventSource> unwrap();
 
   virtual ~IEventSourceWrapper();
@@ -1,4 +1,6 @@
 #include "nuis/eventinput/NormalizedEventSource.h"
+#include "nuis/eventinput/ReadAheadEventSource.h"
+#include "nuis/eventinput/Skim.h"
 
 #include "nuis/except.h"
 #include "nuis/log.txx"
@@ -6,13 +8,58 @@
 #include "NuHepMC/EventUtils.hxx"
 #include "NuHepMC/FATXUtils.hxx"
 
+#include "HepMC3/Attribute.h"
 #include "HepMC3/GenParticle.h"
+#include "HepMC3/GenRunInfo.h"
 
 DECLARE_NUISANCE_EXCEPT(EventMomentumUnitNotMeV);
 DECLARE_NUISANCE_EXCEPT(InvalidXSUnitsForNormalization);
 
 namespace nuis {
 
+namespace {
+// returns the factor to convert a cross section in input_units to the
+// requested units for a target with target_A nucleons
+std::function<double(NuHepMC::CrossSection::Units::Unit const &, int)>
+ExternalUnitsScale(NuHepMC::CrossSection::Units::Unit const &input_units) {
+  return [=](NuHepMC::CrossSection::Units::Unit const &to_units,
+             int target_A) {
+    using namespace NuHepMC::CrossSection::Units;
+    static std::map<Scale, double> const xsunit_factors = {
+        {Scale::pb, pb},
+        {Scale::cm2, cm2},
+        {Scale::cm2_ten38, cm2_ten38},
+    };
+
+    // pb -> cm2 : 1E-36
+    // 1      1E36
+    //   1 / 1E36 = 1E-36!
+    double unit_sf = xsunit_factors.at(input_units.scale) /
+                     xsunit_factors.at(to_units.scale);
+
+    if (input_units.tgtscale == to_units.tgtscale) {
+      return unit_sf;
+    }
+
+    if ((input_units.tgtscale == TargetScale::PerAtom) &&
+        (to_units.tgtscale == TargetScale::PerNucleon)) {
+      return unit_sf / double(target_A);
+    } else if ((input_units.tgtscale == TargetScale::PerNucleon) &&
+               (to_units.tgtscale == TargetScale::PerAtom)) {
+      return unit_sf * double(target_A);
+    } else {
+      throw InvalidXSUnitsForNormalization()
+          << "Cannot convert input cross section units: " << input_units
+          << " to requested units: " << to_units
+          << " for external fatx scaling without additional information, "
+             "please convert the fatx to the required units manually and "
+             "specify those units as the input units when creating the "
+             "NormalizedEventSource.";
+    }
+  };
+}
+} // namespace
+
 std::optional<EventCVWeightPair>
 NormalizedEventSource::process(std::shared_ptr<HepMC3::GenEvent> ev) {
   if (!ev) {
@@ -45,6 +92,21 @@ NormalizedEventSource::process(std::shared_ptr<HepMC3::GenEvent> ev) {
   return EventCVWeightPair{ev, xs_acc->process(*ev)};
 }
 
+bool NormalizedEventSource::prefiltered(HepMC3::GenEvent const &ev) {
+  return IsPrefilteredStub(ev) ||
+         (converted_prefilter && !converted_prefilter(GetEventHeader(ev)));
+}
+
+std::shared_ptr<HepMC3::GenEvent>
+NormalizedEventSource::skip_prefiltered(std::shared_ptr<HepMC3::GenEvent> ev) {
+  // rejected entries still count towards the normalization
+  while (ev && prefiltered(*ev)) {
+    xs_acc->process(*ev);
+    ev = wrapped_ev_source->next();
+  }
+  return ev;
+}
+
 NormalizedEventSource::NormalizedEventSource(
     std::shared_ptr<IEventSource> evs)
     : IEventSourceWrapper(evs), external_fatx{0xdeadbeef} {}
@@ -54,41 +116,7 @@ NormalizedEventSource::NormalizedEventSource(
     NuHepMC::CrossSection::Units::Unit const &input_units)
     : IEventSourceWrapper(evs), external_fatx{fatx} {
 
-  external_units_scale = [=](NuHepMC::CrossSection::Units::Unit const &to_units,
-                             int target_A) {
-    using namespace NuHepMC::CrossSection::Units;
-    static std::map<Scale, double> const xsunit_factors = {
-        {Scale::pb, pb},
-        {Scale::cm2, cm2},
-        {Scale::cm2_ten38, cm2_ten38},
-    };
-
-    // pb -> cm2 : 1E-36
-    // 1      1E36
-    //   1 / 1E36 = 1E-36!
-    double unit_sf = xsunit_factors.at(input_units.scale) /
-                     xsunit_factors.at(to_units.scale);
-
-    if (input_units.tgtscale == to_units.tgtscale) {
-      return unit_sf;
-    }
-
-    if ((input_units.tgtscale == TargetScale::PerAtom) &&
-        (to_units.tgtscale == TargetScale::PerNucleon)) {
-      return unit_sf / double(target_A);
-    } else if ((input_units.tgtscale == TargetScale::PerNucleon) &&
-               (to_units.tgtscale == TargetScale::PerAtom)) {
-      return unit_sf * double(target_A);
-    } else {
-      throw InvalidXSUnitsForNormalization()
-          << "Cannot convert input cross section units: " << input_units
-          << " to requested units: " << to_units
-          << " for external fatx scaling without additional information, "
-             "please convert the fatx to the required units manually and "
-             "specify those units as the input units when creating the "
-             "NormalizedEventSource.";
-    }
-  };
+  external_units_scale = ExternalUnitsScale(input_units);
 }
 
 NormalizedEventSource::NormalizedEventSource(
@@ -101,12 +129,36 @@ std::optional<EventCVWeightPair> NormalizedEventSource::first() {
     return std::optional<EventCVWeightPair>();
   }
 
+  auto ev = wrapped_ev_source->first();
+  if (!ev) {
+    return std::optional<EventCVWeightPair>();
+  }
+
+  // skims carry the normalization of the sample that they were taken from
+  auto gri = ev->run_info();
+  auto skim_fatx =
+      gri ? gri->attribute<HepMC3::DoubleAttribute>(SkimAttributes::FATX)
+          : nullptr;
+  if (skim_fatx && ((external_fatx == 0xdeadbeef) || skim_norm)) {
+    auto skim_sumw =
+        gri->attribute<HepMC3::DoubleAttribute>(SkimAttributes::SumWeights);
+    auto skim_nevents =
+        gri->attribute<HepMC3::LongAttribute>(SkimAttributes::NEvents);
+    external_fatx = skim_fatx->value();
+    external_units_scale =
+        ExternalUnitsScale(NuHepMC::CrossSection::Units::cm2ten38_PerNucleon);
+    skim_norm = NormInfo{external_fatx, skim_sumw ? skim_sumw->value() : 0,
+                         skim_nevents ? size_t(skim_nevents->value()) : 0};
+    log_debug("NormalizedEventSource reading a skim, using the parent "
+              "normalization: fatx = {}, sumweights = {}, nevents = {}",
+              skim_norm->fatx, skim_norm->sumweights, skim_norm->nevents);
+  }
+
   try {
     if (external_fatx != 0xdeadbeef) {
       xs_acc = NuHepMC::FATX::MakeAccumulator("Dummy");
     } else {
-      xs_acc = NuHepMC::FATX::MakeAccumulator(
-          wrapped_ev_source->first()->run_info());
+      xs_acc = NuHepMC::FATX::MakeAccumulator(ev->run_info());
     }
   } catch (NuHepMC::except const &ex) {
     log_warn("NormalizedEventSource::first failed to determine cross-section "
@@ -114,17 +166,59 @@ std::optional<EventCVWeightPair> NormalizedEventSource::first() {
              "file, request an unnormalized EventSource: {}", ex.what());
     return std::optional<EventCVWeightPair>();
   }
-  return process(wrapped_ev_source->first());
+  return process(skip_prefiltered(ev));
 }
 
 std::optional<EventCVWeightPair> NormalizedEventSource::next() {
-  return process(wrapped_ev_source->next());
+  return process(skip_prefiltered(wrapped_ev_source->next()));
+}
+
+size_t NormalizedEventSource::next_batch(std::vector<EventCVWeightPair> &batch,
+                                         size_t n) {
+  batch.clear();
+  while ((batch.size() < n) &&
+         wrapped_ev_source->next_batch(ev_batch, n - batch.size())) {
+    for (auto &ev : ev_batch) {
+      if (prefiltered(*ev)) {
+        xs_acc->process(*ev);
+        continue;
+      }
+      batch.push_back(process(std::move(ev)).value());
+    }
+  }
+  ev_batch.clear();
+  return batch.size();
+}
+
+bool NormalizedEventSource::set_prefilter(EventHeaderFilterFunc filt) {
+  converted_prefilter = nullptr;
+  if (!wrapped_ev_source) {
+    return false;
+  }
+  if (wrapped_ev_source->set_prefilter(filt)) {
+    return true;
+  }
+  converted_prefilter = filt;
+  return false;
+}
+
+void NormalizedEventSource::read_ahead(size_t depth) {
+  if (!wrapped_ev_source ||
+      std::dynamic_pointer_cast<ReadAheadEventSource>(wrapped_ev_source)) {
+    return;
+  }
+  wrapped_ev_source =
+      std::make_shared<ReadAheadEventSource>(wrapped_ev_source, depth);
 }
 
 NormInfo NormalizedEventSource::norm_info(
     NuHepMC::CrossSection::Units::Unit const &units) {
 
-  if (external_fatx != 0xdeadbeef) {
+  if (skim_norm) {
+    return {skim_norm->fatx *
+                external_units_scale(units, xs_acc->TargetTotalNucleons()),
+            skim_norm->sumweights, skim_norm->nevents};
+  } else if (external_fatx != 0xdeadbeef) {
     return {external_fatx *
                 external_units_scale(units, xs_acc->TargetTotalNucleons()),
             xs_acc->sumweights(), xs_acc->events()};
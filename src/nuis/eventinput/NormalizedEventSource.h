@@ -32,6 +32,19 @@ class NormalizedEventSource : public IEventSourceWrapper {
 
   std::shared_ptr<NuHepMC::FATX::Accumulator> xs_acc;
 
+  // set when reading a skim, see Skim.h
+  std::optional<NormInfo> skim_norm;
+
+  // reused between calls to next_batch to avoid reallocating
+  std::vector<std::shared_ptr<HepMC3::GenEvent>> ev_batch;
+
+  // applied to converted events if the wrapped source could not take the
+  // prefilter itself
+  EventHeaderFilterFunc converted_prefilter;
+  bool prefiltered(HepMC3::GenEvent const &ev);
+  std::shared_ptr<HepMC3::GenEvent>
+  skip_prefiltered(std::shared_ptr<HepMC3::GenEvent> ev);
+
   std::optional<EventCVWeightPair>
   process(std::shared_ptr<HepMC3::GenEvent> ev);
 
@@ -46,6 +59,22 @@ public:
 
   virtual std::optional<EventCVWeightPair> first();
   virtual std::optional<EventCVWeightPair> next();
+  // Clears batch and fills it with up to n normalized events, see
+  // IEventSource::next_batch. Must be called after first().
+  virtual size_t next_batch(std::vector<EventCVWeightPair> &batch, size_t n);
+
+  // Only events passing filt are returned. The filter is pushed down into the
+  // wrapped source where possible, so that rejected entries are never fully
+  // converted, otherwise it is evaluated on the converted events. Either way,
+  // rejected entries still contribute to norm_info. Returns true if the filter
+  // was pushed down. Should be called before first().
+  virtual bool set_prefilter(EventHeaderFilterFunc filt);
+
+  // Moves decoding of the wrapped source onto a background thread that buffers
+  // up to depth events (see ReadAheadEventSource). The FATX accumulator still
+  // runs on the caller's thread, in event order, so norm_info is unchanged.
+  // Should be called before first().
+  virtual void read_ahead(size_t depth);
 
   virtual NormInfo norm_info(NuHepMC::CrossSection::Units::Unit const &units);
   virtual ~NormalizedEventSource();
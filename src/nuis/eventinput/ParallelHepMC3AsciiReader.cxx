@@ -0,0 +1,365 @@
+#include "nuis/eventinput/ParallelHepMC3AsciiReader.h"
+
+#include "nuis/except.h"
+#include "nuis/log.txx"
+
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenRunInfo.h"
+#include "HepMC3/ReaderAscii.h"
+
+#include "fmt/core.h"
+
+#ifdef NUIS_EVENTINPUT_ZLIB_ENABLED
+#include "zlib.h"
+#else
+#include <fstream>
+#endif
+
+#include <algorithm>
+#include <sstream>
+
+namespace nuis {
+
+DECLARE_NUISANCE_EXCEPT(HepMC3AsciiInputError);
+
+namespace {
+
+constexpr size_t const read_block_size = 1 << 20;
+
+std::string const start_listing = "HepMC::Asciiv3-START_EVENT_LISTING";
+std::string const end_listing = "HepMC::Asciiv3-END_EVENT_LISTING";
+
+// gzread transparently passes through uncompressed files, without zlib only
+// plain text files can be read
+class TextSource {
+#ifdef NUIS_EVENTINPUT_ZLIB_ENABLED
+  gzFile gzf;
+#else
+  std::ifstream fin;
+#endif
+
+public:
+  TextSource(std::filesystem::path const &fp) {
+#ifdef NUIS_EVENTINPUT_ZLIB_ENABLED
+    gzf = gzopen(fp.c_str(), "rb");
+    if (!gzf) {
+      throw HepMC3AsciiInputError() << "Failed to open " << fp.native();
+    }
+    gzbuffer(gzf, 1 << 17);
+#else
+    fin.open(fp, std::ios::binary);
+    if (!fin) {
+      throw HepMC3AsciiInputError() << "Failed to open " << fp.native();
+    }
+#endif
+  }
+
+  // returns the number of bytes read, 0 at the end of the file
+  size_t read(char *buf, size_t n) {
+#ifdef NUIS_EVENTINPUT_ZLIB_ENABLED
+    int nread = gzread(gzf, buf, unsigned(n));
+    if (nread < 0) {
+      int errnum;
+      throw HepMC3AsciiInputError()
+          << "gzread failed: " << gzerror(gzf, &errnum);
+    }
+    return size_t(nread);
+#else
+    fin.read(buf, std::streamsize(n));
+    return size_t(fin.gcount());
+#endif
+  }
+
+  ~TextSource() {
+#ifdef NUIS_EVENTINPUT_ZLIB_ENABLED
+    gzclose(gzf);
+#endif
+  }
+};
+
+bool IsEventStart(std::string const &buf, size_t pos) {
+  return buf.compare(pos, 2, "E ") == 0;
+}
+
+} // namespace
+
+ParallelHepMC3AsciiReader::ParallelHepMC3AsciiReader(
+    std::filesystem::path const &fp, size_t nthreads, size_t evs_per_chunk)
+    : filepath{fp}, nworkers{std::max(nthreads, size_t(1))},
+      events_per_chunk{std::max(evs_per_chunk, size_t(1))},
+      max_chunks_in_flight{4 * nworkers}, header_ready{false},
+      is_ascii{false}, nchunks_split{0}, next_chunk{0}, splitter_done{false},
+      stop_requested{false}, current_it{0} {
+
+  splitter = std::thread(&ParallelHepMC3AsciiReader::split, this);
+  for (size_t i = 0; i < nworkers; ++i) {
+    workers.emplace_back(&ParallelHepMC3AsciiReader::parse, this);
+  }
+}
+
+void ParallelHepMC3AsciiReader::split() {
+  try {
+    TextSource src(filepath);
+
+    std::vector<char> block(read_block_size);
+    std::string buf;
+    bool in_header = true;
+    // buf[chunk_begin, ...) has not yet been handed to the workers, events
+    // starts before scan_from have been counted in nevents
+    size_t chunk_begin = 0;
+    size_t scan_from = 0;
+    size_t nevents = 0;
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lk(pipeline_mutex);
+        if (stop_requested) {
+          break;
+        }
+      }
+
+      size_t nread = src.read(block.data(), block.size());
+      bool eof = (nread == 0);
+      buf.append(block.data(), nread);
+
+      if (in_header) {
+        size_t first_event = buf.find("\nE ");
+        // keep reading until the first event unless this clearly isn't a
+        // HepMC3 ASCII file
+        if ((first_event == std::string::npos) && !eof &&
+            (buf.size() < 64 || (buf.rfind("HepMC::Version", 0) == 0))) {
+          continue;
+        }
+        first_event = (first_event == std::string::npos) ? buf.size()
+                                                         : (first_event + 1);
+
+        std::string hdr = buf.substr(0, first_event);
+        bool ascii = (hdr.rfind("HepMC::Version", 0) == 0) &&
+                     (hdr.find(start_listing) != std::string::npos);
+
+        std::shared_ptr<HepMC3::GenRunInfo> run_info;
+        if (ascii) {
+          // the run info is parsed once from the header, the reader stops at
+          // the end of the listing
+          std::istringstream iss(hdr + end_listing + "\n");
+          HepMC3::ReaderAscii rdr(iss);
+          HepMC3::GenEvent evt;
+          rdr.read_event(evt);
+          run_info = rdr.run_info();
+          if (!run_info) {
+            run_info = std::make_shared<HepMC3::GenRunInfo>();
+          }
+        }
+
+        {
+          std::unique_lock<std::mutex> lk(pipeline_mutex);
+          is_ascii = ascii;
+          gri = run_info;
+          if (ascii) {
+            auto preamble_end = hdr.find('\n', hdr.find(start_listing));
+            listing_preamble =
+                hdr.substr(0, std::min(preamble_end + 1, hdr.size()));
+          }
+          header_ready = true;
+        }
+        header_cv.notify_all();
+
+        if (!ascii) {
+          break;
+        }
+
+        buf.erase(0, first_event);
+        in_header = false;
+      }
+
+      size_t pos = scan_from;
+      while (true) {
+        auto nl = buf.find("\nE ", pos);
+        if (nl == std::string::npos) {
+          // the pattern may straddle the next block
+          scan_from = std::max(pos, buf.size() > 2 ? buf.size() - 2 : 0);
+          break;
+        }
+        pos = nl + 1;
+        if (++nevents == events_per_chunk) {
+          push_chunk(buf.substr(chunk_begin, pos - chunk_begin), nevents);
+          chunk_begin = pos;
+          nevents = 0;
+        }
+      }
+
+      if (eof) {
+        // the last event has no following event start to count it
+        if (IsEventStart(buf, chunk_begin)) {
+          push_chunk(buf.substr(chunk_begin), nevents + 1);
+        }
+        break;
+      }
+
+      buf.erase(0, chunk_begin);
+      scan_from -= chunk_begin;
+      chunk_begin = 0;
+    }
+  } catch (...) {
+    std::unique_lock<std::mutex> lk(pipeline_mutex);
+    splitter_error = std::current_exception();
+  }
+
+  {
+    std::unique_lock<std::mutex> lk(pipeline_mutex);
+    header_ready = true;
+    splitter_done = true;
+  }
+  header_cv.notify_all();
+  tasks_cv.notify_all();
+  results_cv.notify_all();
+}
+
+void ParallelHepMC3AsciiReader::push_chunk(std::string chunk,
+                                           size_t nevents) {
+  std::unique_lock<std::mutex> lk(pipeline_mutex);
+  space_cv.wait(lk, [this] {
+    return stop_requested ||
+           ((nchunks_split - next_chunk) < max_chunks_in_flight);
+  });
+  if (stop_requested) {
+    return;
+  }
+  tasks.push_back(ChunkTask{nchunks_split++, nevents, std::move(chunk)});
+  lk.unlock();
+  tasks_cv.notify_one();
+}
+
+std::vector<std::shared_ptr<HepMC3::GenEvent>>
+ParallelHepMC3AsciiReader::parse_chunk(std::string const &chunk,
+                                       size_t nevents) {
+  // chunks end in a newline unless they run to the end of the file
+  std::istringstream iss(listing_preamble + chunk +
+                         ((chunk.back() == '\n') ? "" : "\n") + end_listing +
+                         "\n");
+  HepMC3::ReaderAscii rdr(iss);
+
+  std::vector<std::shared_ptr<HepMC3::GenEvent>> events;
+  while (true) {
+    auto evt = std::make_shared<HepMC3::GenEvent>();
+    rdr.read_event(*evt);
+    if (rdr.failed()) {
+      break;
+    }
+    evt->set_run_info(gri);
+    events.push_back(std::move(evt));
+  }
+
+  // the reader stops at a malformed event as if the chunk had ended
+  if (events.size() != nevents) {
+    throw HepMC3AsciiInputError()
+        << "Parsed " << events.size() << " of the " << nevents
+        << " events in a chunk of " << filepath.native() << ", failed after "
+        << (events.size()
+                ? fmt::format("event number {}", events.back()->event_number())
+                : std::string("the start of the chunk"));
+  }
+  return events;
+}
+
+void ParallelHepMC3AsciiReader::parse() {
+  while (true) {
+    std::unique_lock<std::mutex> lk(pipeline_mutex);
+    tasks_cv.wait(lk, [this] {
+      return stop_requested || tasks.size() || splitter_done;
+    });
+    if (stop_requested || !tasks.size()) {
+      return;
+    }
+    auto task = std::move(tasks.front());
+    tasks.pop_front();
+    lk.unlock();
+
+    ChunkResult res;
+    try {
+      res.events = parse_chunk(task.text, task.nevents);
+    } catch (...) {
+      res.error = std::current_exception();
+    }
+
+    lk.lock();
+    results[task.index] = std::move(res);
+    lk.unlock();
+    results_cv.notify_all();
+  }
+}
+
+bool ParallelHepMC3AsciiReader::pop_chunk() {
+  std::unique_lock<std::mutex> lk(pipeline_mutex);
+  results_cv.wait(lk, [this] {
+    return results.count(next_chunk) ||
+           (splitter_done && (next_chunk >= nchunks_split));
+  });
+
+  if (!results.count(next_chunk)) {
+    if (splitter_error) {
+      auto ex = splitter_error;
+      splitter_error = nullptr;
+      std::rethrow_exception(ex);
+    }
+    return false;
+  }
+
+  auto res = std::move(results[next_chunk]);
+  results.erase(next_chunk);
+  next_chunk++;
+  lk.unlock();
+  space_cv.notify_one();
+
+  if (res.error) {
+    std::rethrow_exception(res.error);
+  }
+  current = std::move(res.events);
+  current_it = 0;
+  return true;
+}
+
+bool ParallelHepMC3AsciiReader::good() {
+  std::unique_lock<std::mutex> lk(pipeline_mutex);
+  header_cv.wait(lk, [this] { return header_ready; });
+  if (splitter_error && !is_ascii) {
+    try {
+      std::rethrow_exception(splitter_error);
+    } catch (std::exception const &ex) {
+      log_warn("[ParallelHepMC3AsciiReader]: {}", ex.what());
+    }
+  }
+  return is_ascii;
+}
+
+std::shared_ptr<HepMC3::GenRunInfo> ParallelHepMC3AsciiReader::run_info() {
+  return good() ? gri : nullptr;
+}
+
+std::shared_ptr<HepMC3::GenEvent> ParallelHepMC3AsciiReader::next() {
+  while (current_it >= current.size()) {
+    if (!pop_chunk()) {
+      return nullptr;
+    }
+  }
+  return std::move(current[current_it++]);
+}
+
+ParallelHepMC3AsciiReader::~ParallelHepMC3AsciiReader() {
+  {
+    std::unique_lock<std::mutex> lk(pipeline_mutex);
+    stop_requested = true;
+  }
+  tasks_cv.notify_all();
+  space_cv.notify_all();
+  if (splitter.joinable()) {
+    splitter.join();
+  }
+  for (auto &w : workers) {
+    if (w.joinable()) {
+      w.join();
+    }
+  }
+}
+
+} // namespace nuis
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "nuis/log.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace HepMC3 {
+class GenEvent;
+class GenRunInfo;
+} // namespace HepMC3
+
+namespace nuis {
+
+/// Reads HepMC3 ASCII (v3) files, optionally gzipped, with a pipeline of
+/// threads: one thread inflates the input and splits the text into chunks of
+/// whole events, and a pool of workers parses the chunks into GenEvents.
+/// Events are returned by next() in file order.
+///
+/// The run info is parsed once from the file header and shared by every event.
+/// Inputs that are not HepMC3 ASCII, e.g. protobuf files, are rejected by
+/// good() and should be read with a NuHepMC::Reader instead.
+class ParallelHepMC3AsciiReader : public nuis_named_log("EventInput") {
+
+  std::filesystem::path filepath;
+  size_t nworkers;
+  size_t events_per_chunk;
+  // chunks that may be in the pipeline, split but not yet returned by next()
+  size_t max_chunks_in_flight;
+
+  std::shared_ptr<HepMC3::GenRunInfo> gri;
+
+  // set by the splitter thread once the header has been read
+  bool header_ready;
+  bool is_ascii;
+  // the lines that open the event listing, prepended to every chunk
+  std::string listing_preamble;
+
+  struct ChunkResult {
+    std::vector<std::shared_ptr<HepMC3::GenEvent>> events;
+    std::exception_ptr error;
+  };
+
+  struct ChunkTask {
+    size_t index;
+    // the number of event records that the splitter found in text
+    size_t nevents;
+    std::string text;
+  };
+
+  std::deque<ChunkTask> tasks;
+  std::map<size_t, ChunkResult> results;
+  size_t nchunks_split;
+  size_t next_chunk;
+  bool splitter_done;
+  bool stop_requested;
+  std::exception_ptr splitter_error;
+
+  std::mutex pipeline_mutex;
+  std::condition_variable header_cv;
+  std::condition_variable tasks_cv;
+  std::condition_variable space_cv;
+  std::condition_variable results_cv;
+
+  std::thread splitter;
+  std::vector<std::thread> workers;
+
+  // the chunk currently being handed out by next()
+  std::vector<std::shared_ptr<HepMC3::GenEvent>> current;
+  size_t current_it;
+
+  void split();
+  void push_chunk(std::string chunk, size_t nevents);
+  void parse();
+  std::vector<std::shared_ptr<HepMC3::GenEvent>>
+  parse_chunk(std::string const &chunk, size_t nevents);
+  bool pop_chunk();
+
+public:
+  constexpr static size_t const default_events_per_chunk = 100;
+
+  ParallelHepMC3AsciiReader(
+      std::filesystem::path const &fp, size_t nthreads,
+      size_t events_per_chunk = default_events_per_chunk);
+
+  // blocks until the header has been read, false if the input is not HepMC3
+  // ASCII
+  bool good();
+  std::shared_ptr<HepMC3::GenRunInfo> run_info();
+
+  // returns nullptr at the end of the file
+  std::shared_ptr<HepMC3::GenEvent> next();
+
+  ~ParallelHepMC3AsciiReader();
+};
+
+} // namespace nuis
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "nuis/eventinput/IEventSource.h"
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace HepMC3 {
+class GenRunInfo;
+}
+
+namespace nuis {
+
+/// A structure-of-arrays batch of events for flat-kinematics analyses that
+/// never need the HepMC3 graph. The particles of event i are the entries
+/// [event_offsets[i], event_offsets[i+1]) of the per-particle arrays.
+/// Momenta are in MeV and particle statuses follow NuHepMC.
+///
+/// Events with no particles were rejected by a prefilter, like prefiltered
+/// stubs they should only be used for the normalization.
+struct ParticleTable {
+  constexpr static size_t const npos = std::numeric_limits<size_t>::max();
+
+  // per-event, event_offsets has one more entry than there are events
+  std::vector<size_t> event_offsets{0};
+  std::vector<long> event_number;
+  std::vector<double> weight;
+  // the E.C.2 total cross section in pb, NaN for sources that don't set it
+  std::vector<double> total_xs;
+  std::vector<int> process_id;
+  std::vector<int> native_mode;
+  std::vector<int> probe_pdg;
+  std::vector<double> probe_energy;
+  std::vector<int> target_pdg;
+
+  // per-particle
+  std::vector<int> pdg;
+  std::vector<int> status;
+  std::vector<double> px;
+  std::vector<double> py;
+  std::vector<double> pz;
+  std::vector<double> E;
+
+  size_t nevents() const { return event_offsets.size() - 1; }
+  size_t nparticles() const { return pdg.size(); }
+
+  size_t begin_particle(size_t ev) const { return event_offsets[ev]; }
+  size_t end_particle(size_t ev) const { return event_offsets[ev + 1]; }
+
+  bool prefiltered(size_t ev) const {
+    return begin_particle(ev) == end_particle(ev);
+  }
+
+  EventHeader header(size_t ev) const {
+    return {process_id[ev], native_mode[ev], probe_pdg[ev], probe_energy[ev],
+            target_pdg[ev]};
+  }
+
+  // index of the highest-energy particle in event ev with the given pdg and
+  // status, npos if there is none
+  size_t leading_particle(size_t ev, int pid, int st) const {
+    size_t best = npos;
+    for (size_t i = begin_particle(ev); i < end_particle(ev); ++i) {
+      if ((pdg[i] == pid) && (status[i] == st) &&
+          ((best == npos) || (E[i] > E[best]))) {
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  void clear() {
+    event_offsets.assign(1, 0);
+    event_number.clear();
+    for (auto v : {&weight, &total_xs, &probe_energy, &px, &py, &pz, &E}) {
+      v->clear();
+    }
+    for (auto v : {&process_id, &native_mode, &probe_pdg, &target_pdg, &pdg,
+                   &status}) {
+      v->clear();
+    }
+  }
+
+  // starts a new event, subsequent calls to add_particle fill it
+  void add_event(long evnum, EventHeader const &hdr, double w,
+                 double xs = std::numeric_limits<double>::quiet_NaN()) {
+    event_offsets.push_back(event_offsets.back());
+    event_number.push_back(evnum);
+    weight.push_back(w);
+    total_xs.push_back(xs);
+    process_id.push_back(hdr.process_id);
+    native_mode.push_back(hdr.native_mode);
+    probe_pdg.push_back(hdr.probe_pdg);
+    probe_energy.push_back(hdr.probe_energy);
+    target_pdg.push_back(hdr.target_pdg);
+  }
+
+  void add_particle(int pid, int st, double ppx, double ppy, double ppz,
+                    double pE) {
+    pdg.push_back(pid);
+    status.push_back(st);
+    px.push_back(ppx);
+    py.push_back(ppy);
+    pz.push_back(ppz);
+    E.push_back(pE);
+    event_offsets.back()++;
+  }
+};
+
+/// Implemented by event sources that can fill ParticleTables directly from
+/// their native format, skipping the GenParticle/GenVertex graph. Tables
+/// follow the same entry order, seek position and prefilter as the
+/// IEventSource interface of the same source.
+class IParticleTableSource {
+public:
+  // Rewinds the source and clears and fills tbl with up to n events, returns
+  // the number of events filled
+  virtual size_t first_table(ParticleTable &tbl, size_t n) = 0;
+  virtual size_t next_table(ParticleTable &tbl, size_t n) = 0;
+
+  // the run info that the GenEvents of this source would carry, used to build
+  // the normalization
+  virtual std::shared_ptr<HepMC3::GenRunInfo> run_info() = 0;
+
+  virtual ~IParticleTableSource() {}
+};
+
+using IParticleTableSourcePtr = std::shared_ptr<IParticleTableSource>;
+
+} // namespace nuis
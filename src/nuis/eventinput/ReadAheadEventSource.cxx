@@ -0,0 +1,173 @@
+#include "nuis/eventinput/ReadAheadEventSource.h"
+
+#include "nuis/log.txx"
+
+#include <algorithm>
+#include <iterator>
+
+namespace nuis {
+
+ReadAheadEventSource::ReadAheadEventSource(IEventSourcePtr evs, size_t depth)
+    : IEventSourceWrapper(evs), queue_depth{std::max(depth, size_t(1))},
+      producer_done{true}, stop_requested{false}, start_pending{false} {}
+
+void ReadAheadEventSource::produce() {
+  try {
+    while (true) {
+      auto ev = wrapped_ev_source->next();
+
+      std::unique_lock<std::mutex> lk(queue_mutex);
+      if (!ev) {
+        break;
+      }
+      queue_not_full.wait(
+          lk, [this] { return stop_requested || (queue.size() < queue_depth); });
+      if (stop_requested) {
+        break;
+      }
+      queue.push_back(std::move(ev));
+      lk.unlock();
+      queue_not_empty.notify_one();
+    }
+  } catch (...) {
+    std::unique_lock<std::mutex> lk(queue_mutex);
+    producer_exception = std::current_exception();
+  }
+
+  {
+    std::unique_lock<std::mutex> lk(queue_mutex);
+    producer_done = true;
+  }
+  queue_not_empty.notify_all();
+}
+
+void ReadAheadEventSource::start_producer() {
+  queue.clear();
+  producer_done = false;
+  stop_requested = false;
+  producer_exception = nullptr;
+  producer = std::thread(&ReadAheadEventSource::produce, this);
+}
+
+void ReadAheadEventSource::stop_producer() {
+  {
+    std::unique_lock<std::mutex> lk(queue_mutex);
+    stop_requested = true;
+  }
+  queue_not_full.notify_all();
+  if (producer.joinable()) {
+    producer.join();
+  }
+  queue.clear();
+}
+
+std::shared_ptr<HepMC3::GenEvent> ReadAheadEventSource::first() {
+  stop_producer();
+  start_pending = false;
+
+  if (!wrapped_ev_source) {
+    return nullptr;
+  }
+
+  // the first event is read synchronously so that callers can immediately
+  // inspect the run info and so that the wrapped source is fully opened
+  // before another thread touches it.
+  auto ev = wrapped_ev_source->first();
+  if (!ev) {
+    return nullptr;
+  }
+
+  start_pending = true;
+  return ev;
+}
+
+std::shared_ptr<HepMC3::GenEvent> ReadAheadEventSource::next() {
+  if (start_pending) {
+    log_debug("[ReadAheadEventSource]: starting read-ahead thread with a "
+              "queue depth of {} events.",
+              queue_depth);
+    start_pending = false;
+    start_producer();
+  }
+
+  std::unique_lock<std::mutex> lk(queue_mutex);
+  queue_not_empty.wait(lk, [this] { return producer_done || queue.size(); });
+
+  if (!queue.size()) {
+    if (producer_exception) {
+      auto ex = producer_exception;
+      producer_exception = nullptr;
+      std::rethrow_exception(ex);
+    }
+    return nullptr;
+  }
+
+  auto ev = std::move(queue.front());
+  queue.pop_front();
+  lk.unlock();
+  queue_not_full.notify_one();
+  return ev;
+}
+
+size_t ReadAheadEventSource::next_batch(
+    std::vector<std::shared_ptr<HepMC3::GenEvent>> &batch, size_t n) {
+  batch.clear();
+  if (!n) {
+    return 0;
+  }
+
+  if (start_pending) {
+    log_debug("[ReadAheadEventSource]: starting read-ahead thread with a "
+              "queue depth of {} events.",
+              queue_depth);
+    start_pending = false;
+    start_producer();
+  }
+
+  std::unique_lock<std::mutex> lk(queue_mutex);
+  queue_not_empty.wait(lk, [this] { return producer_done || queue.size(); });
+
+  if (!queue.size() && producer_exception) {
+    auto ex = producer_exception;
+    producer_exception = nullptr;
+    std::rethrow_exception(ex);
+  }
+
+  size_t npop = std::min(n, queue.size());
+  batch.reserve(npop);
+  std::move(queue.begin(), queue.begin() + npop, std::back_inserter(batch));
+  queue.erase(queue.begin(), queue.begin() + npop);
+  lk.unlock();
+  queue_not_full.notify_one();
+  return batch.size();
+}
+
+bool ReadAheadEventSource::set_prefilter(EventHeaderFilterFunc filt) {
+  return wrapped_ev_source && wrapped_ev_source->set_prefilter(filt);
+}
+
+bool ReadAheadEventSource::seekable() {
+  return wrapped_ev_source && wrapped_ev_source->seekable();
+}
+
+size_t ReadAheadEventSource::size() {
+  return wrapped_ev_source ? wrapped_ev_source->size() : 0;
+}
+
+bool ReadAheadEventSource::seek(size_t entry) {
+  stop_producer();
+  start_pending = false;
+
+  if (!wrapped_ev_source || !wrapped_ev_source->seek(entry)) {
+    std::unique_lock<std::mutex> lk(queue_mutex);
+    producer_done = true;
+    return false;
+  }
+
+  start_pending = true;
+  return true;
+}
+
+ReadAheadEventSource::~ReadAheadEventSource() { stop_producer(); }
+
+} // namespace nuis
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "nuis/eventinput/IEventSource.h"
+#include "nuis/eventinput/IEventSourceWrapper.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace nuis {
+
+/// An event source wrapper that decodes events from the wrapped source on a
+/// background thread into a bounded queue, so that next() on the consumer side
+/// only has to pop an already-built event.
+///
+/// N.B. The wrapped source is only ever touched by one thread at a time, but
+/// that thread is not the caller's. Plugin-specific accessors that re-read the
+/// native event record (e.g. GHEP3EventSource::EventRecord) must not be used
+/// while the read-ahead thread is running.
+class ReadAheadEventSource : public IEventSource, public IEventSourceWrapper {
+
+  size_t queue_depth;
+
+  std::deque<std::shared_ptr<HepMC3::GenEvent>> queue;
+  bool producer_done;
+  bool stop_requested;
+  // the thread is started by the first next() after first() or seek(), so that
+  // rewinding without reading anything stays cheap
+  bool start_pending;
+  std::exception_ptr producer_exception;
+
+  std::mutex queue_mutex;
+  std::condition_variable queue_not_full;
+  std::condition_variable queue_not_empty;
+
+  std::thread producer;
+
+  void start_producer();
+  void stop_producer();
+  void produce();
+
+public:
+  constexpr static size_t const default_queue_depth = 1000;
+
+  ReadAheadEventSource(IEventSourcePtr evs,
+                       size_t depth = default_queue_depth);
+
+  std::shared_ptr<HepMC3::GenEvent> first();
+  std::shared_ptr<HepMC3::GenEvent> next();
+  // pops up to n already-decoded events under a single lock, only waits on the
+  // read-ahead thread if the queue is empty
+  size_t next_batch(std::vector<std::shared_ptr<HepMC3::GenEvent>> &batch,
+                    size_t n);
+
+  bool set_prefilter(EventHeaderFilterFunc filt);
+
+  bool seekable();
+  size_t size();
+  // drains the queue and restarts the read-ahead thread from entry
+  bool seek(size_t entry);
+
+  virtual ~ReadAheadEventSource();
+};
+
+} // namespace nuis
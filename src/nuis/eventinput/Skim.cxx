@@ -0,0 +1,90 @@
+#include "nuis/eventinput/Skim.h"
+
+#include "nuis/except.h"
+#include "nuis/log.txx"
+
+#include "NuHepMC/Reader.hxx"
+#include "NuHepMC/UnitsUtils.hxx"
+#include "NuHepMC/make_writer.hxx"
+
+#include "HepMC3/Attribute.h"
+#include "HepMC3/GenRunInfo.h"
+
+namespace nuis {
+
+DECLARE_NUISANCE_EXCEPT(SkimInputInvalid);
+
+SkimSummary Skim(NormalizedEventSourcePtr evs,
+                 std::function<int(HepMC3::GenEvent const &)> const &sel,
+                 std::filesystem::path const &outfile) {
+
+  auto ev = evs ? evs->first() : std::optional<EventCVWeightPair>();
+  if (!ev) {
+    throw SkimInputInvalid() << "Skim was passed an event source with no "
+                                "events, cannot write "
+                             << outfile.native();
+  }
+  auto gri = ev->evt->run_info();
+
+  // the parent normalisation is only known once every event has been read, but
+  // it has to be in the output header, so selected events are staged in a
+  // temporary file of the same format that is copied over at the end.
+  auto fname = outfile.filename().native();
+  auto ext_dot = fname.find('.');
+  auto stage_path =
+      outfile.parent_path() /
+      ("." + fname.substr(0, ext_dot) + ".skimstage" +
+       ((ext_dot == std::string::npos) ? "" : fname.substr(ext_dot)));
+
+  SkimSummary summary{{0, 0, 0}, 0};
+  {
+    auto stage = NuHepMC::Writer::make_writer(stage_path, gri);
+    for (; ev; ev = evs->next()) {
+      if (!sel(*ev->evt)) {
+        continue;
+      }
+      stage->write_event(*ev->evt);
+      summary.nselected++;
+    }
+    stage->close();
+  }
+
+  summary.parent =
+      evs->norm_info(NuHepMC::CrossSection::Units::cm2ten38_PerNucleon);
+
+  log_info("[Skim]: Selected {}/{} events, parent FATX = {} 1E-38 cm2/nucleon, "
+           "sum of weights = {}",
+           summary.nselected, summary.parent.nevents, summary.parent.fatx,
+           summary.parent.sumweights);
+
+  auto skim_gri = std::make_shared<HepMC3::GenRunInfo>(*gri);
+  skim_gri->add_attribute(
+      SkimAttributes::FATX,
+      std::make_shared<HepMC3::DoubleAttribute>(summary.parent.fatx));
+  skim_gri->add_attribute(
+      SkimAttributes::SumWeights,
+      std::make_shared<HepMC3::DoubleAttribute>(summary.parent.sumweights));
+  skim_gri->add_attribute(
+      SkimAttributes::NEvents,
+      std::make_shared<HepMC3::LongAttribute>(long(summary.parent.nevents)));
+
+  {
+    NuHepMC::Reader rdr(stage_path);
+    auto wrtr = NuHepMC::Writer::make_writer(outfile, skim_gri);
+    HepMC3::GenEvent sev;
+    while (true) {
+      rdr.read_event(sev);
+      if (rdr.failed()) {
+        break;
+      }
+      sev.set_run_info(skim_gri);
+      wrtr->write_event(sev);
+    }
+    wrtr->close();
+  }
+  std::filesystem::remove(stage_path);
+
+  return summary;
+}
+
+} // namespace nuis
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "nuis/eventinput/NormalizedEventSource.h"
+
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace nuis {
+
+// Run info attributes that record the normalisation of the sample that a skim
+// was taken from. NormalizedEventSource uses these in place of its own FATX
+// accumulation when reading a skim. The FATX is stored in 1E-38 cm2/nucleon.
+namespace SkimAttributes {
+inline std::string const FATX = "NUISANCE.Skim.FATX";
+inline std::string const SumWeights = "NUISANCE.Skim.SumWeights";
+inline std::string const NEvents = "NUISANCE.Skim.NEvents";
+} // namespace SkimAttributes
+
+struct SkimSummary {
+  NormInfo parent;
+  size_t nselected;
+};
+
+// Reads evs from first() to the end and writes the events for which sel
+// returns non-zero to outfile. The output run info carries the normalisation
+// of the full input, see SkimAttributes.
+SkimSummary Skim(NormalizedEventSourcePtr evs,
+                 std::function<int(HepMC3::GenEvent const &)> const &sel,
+                 std::filesystem::path const &outfile);
+
+} // namespace nuis
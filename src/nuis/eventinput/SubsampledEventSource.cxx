@@ -0,0 +1,82 @@
+#include "nuis/eventinput/SubsampledEventSource.h"
+
+#include "nuis/except.h"
+#include "nuis/log.txx"
+
+namespace nuis {
+
+DECLARE_NUISANCE_EXCEPT(InvalidSubsampleFraction);
+
+namespace {
+// splitmix64 finalizer
+uint64_t MixBits(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+} // namespace
+
+SubsampledEventSource::SubsampledEventSource(IEventSourcePtr evs,
+                                             double frac, uint64_t sd,
+                                             size_t offset)
+    : IEventSourceWrapper(evs), fraction{frac}, seed{MixBits(sd)},
+      entry_offset{offset}, cursor{0} {
+  if (!(fraction > 0) || (fraction > 1)) {
+    throw InvalidSubsampleFraction()
+        << "SubsampledEventSource requires a fraction in (0, 1], but was "
+           "passed "
+        << fraction;
+  }
+}
+
+bool SubsampledEventSource::keep(size_t entry) const {
+  // top 53 bits -> uniform in [0, 1)
+  double u = double(MixBits(uint64_t(entry + entry_offset) ^ seed) >> 11) *
+             0x1.0p-53;
+  return u < fraction;
+}
+
+std::shared_ptr<HepMC3::GenEvent> SubsampledEventSource::next_kept() {
+  if (wrapped_ev_source->seekable()) {
+    size_t nentries = wrapped_ev_source->size();
+    do {
+      cursor++;
+    } while ((cursor < nentries) && !keep(cursor));
+    return (cursor < nentries) ? wrapped_ev_source->read(cursor) : nullptr;
+  }
+
+  auto ev = wrapped_ev_source->next();
+  while (ev && !keep(++cursor)) {
+    ev = wrapped_ev_source->next();
+  }
+  return ev;
+}
+
+std::shared_ptr<HepMC3::GenEvent> SubsampledEventSource::first() {
+  if (!wrapped_ev_source) {
+    return nullptr;
+  }
+  auto ev = wrapped_ev_source->first();
+  if (!ev) {
+    return nullptr;
+  }
+  if (!wrapped_ev_source->seekable()) {
+    log_debug("[SubsampledEventSource]: wrapped source is not seekable, "
+              "dropped entries will still be decoded.");
+  }
+  cursor = 0;
+  return keep(cursor) ? ev : next_kept();
+}
+
+std::shared_ptr<HepMC3::GenEvent> SubsampledEventSource::next() {
+  return next_kept();
+}
+
+bool SubsampledEventSource::set_prefilter(EventHeaderFilterFunc filt) {
+  return wrapped_ev_source && wrapped_ev_source->set_prefilter(filt);
+}
+
+SubsampledEventSource::~SubsampledEventSource() {}
+
+} // namespace nuis
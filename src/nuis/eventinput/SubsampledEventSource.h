@@ -0,0 +1,45 @@
+#pragma once
+
+#include "nuis/eventinput/IEventSource.h"
+#include "nuis/eventinput/IEventSourceWrapper.h"
+
+#include <cstdint>
+
+namespace nuis {
+
+/// An event source wrapper that keeps a deterministic pseudo-random fraction of
+/// the entries of the wrapped source. Whether an entry is kept depends only on
+/// its index and the seed. Seekable sources jump from one kept entry to the
+/// next, so that dropped entries are never decoded, others are read through.
+///
+/// Wrap with a NormalizedEventSource as usual, the FATX accumulator only sees
+/// the kept entries so norm_info describes the subsample.
+class SubsampledEventSource : public IEventSource, public IEventSourceWrapper {
+
+  double fraction;
+  uint64_t seed;
+  // added to cursor before hashing, see the constructor
+  size_t entry_offset;
+
+  // the index in the wrapped source of the entry most recently returned
+  size_t cursor;
+
+  bool keep(size_t entry) const;
+  std::shared_ptr<HepMC3::GenEvent> next_kept();
+
+public:
+  // entry_offset is the absolute index of the first entry of evs, e.g. the
+  // start of an entry_range, so that an entry is kept or dropped the same way
+  // however the input is split into ranges
+  SubsampledEventSource(IEventSourcePtr evs, double fraction,
+                        uint64_t seed = 0, size_t entry_offset = 0);
+
+  std::shared_ptr<HepMC3::GenEvent> first();
+  std::shared_ptr<HepMC3::GenEvent> next();
+
+  bool set_prefilter(EventHeaderFilterFunc filt);
+
+  virtual ~SubsampledEventSource();
+};
+
+} // namespace nuis
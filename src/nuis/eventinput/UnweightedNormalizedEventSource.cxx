@@ -0,0 +1,107 @@
+#include "nuis/eventinput/UnweightedNormalizedEventSource.h"
+
+#include "nuis/except.h"
+#include "nuis/log.txx"
+
+#include <cmath>
+
+namespace nuis {
+
+DECLARE_NUISANCE_EXCEPT(InvalidUnweightingMaxWeight);
+
+UnweightedNormalizedEventSource::UnweightedNormalizedEventSource(
+    NormalizedEventSourcePtr evs, double maxw, uint64_t sd)
+    // the base only holds the lowest level source so that unwrap() and as<T>()
+    // see through the unweighting, events are always read through weighted
+    : NormalizedEventSource(evs->unwrap()), weighted{evs}, max_weight{maxw},
+      seed{sd}, rng{sd}, sumweights{0}, naccepted{0}, noverweight{0} {
+  if (!(max_weight > 0)) {
+    throw InvalidUnweightingMaxWeight()
+        << "UnweightedNormalizedEventSource requires a positive max_weight, "
+           "but was passed "
+        << max_weight;
+  }
+}
+
+bool UnweightedNormalizedEventSource::accept(EventCVWeightPair &ev) {
+  double w = std::fabs(ev.cv_weight);
+  double sign = std::copysign(1.0, ev.cv_weight);
+
+  if (w > max_weight) {
+    if (!noverweight) {
+      log_warn("[UnweightedNormalizedEventSource]: event weight {} exceeds "
+               "max_weight {}, overweight events are kept with weight "
+               "w/max_weight.",
+               ev.cv_weight, max_weight);
+    }
+    noverweight++;
+    ev.cv_weight = sign * (w / max_weight);
+  } else if (std::uniform_real_distribution<double>(0, max_weight)(rng) < w) {
+    ev.cv_weight = sign;
+  } else {
+    return false;
+  }
+
+  sumweights += ev.cv_weight;
+  naccepted++;
+  return true;
+}
+
+std::optional<EventCVWeightPair> UnweightedNormalizedEventSource::next_accepted(
+    std::optional<EventCVWeightPair> ev) {
+  while (ev && !accept(ev.value())) {
+    ev = weighted->next();
+  }
+  return ev;
+}
+
+std::optional<EventCVWeightPair> UnweightedNormalizedEventSource::first() {
+  rng.seed(seed);
+  sumweights = 0;
+  naccepted = 0;
+  noverweight = 0;
+  return next_accepted(weighted->first());
+}
+
+std::optional<EventCVWeightPair> UnweightedNormalizedEventSource::next() {
+  return next_accepted(weighted->next());
+}
+
+size_t
+UnweightedNormalizedEventSource::next_batch(std::vector<EventCVWeightPair> &batch,
+                                            size_t n) {
+  batch.clear();
+  while ((batch.size() < n) &&
+         weighted->next_batch(weighted_batch, n - batch.size())) {
+    for (auto &ev : weighted_batch) {
+      if (accept(ev)) {
+        batch.push_back(std::move(ev));
+      }
+    }
+  }
+  weighted_batch.clear();
+  return batch.size();
+}
+
+bool UnweightedNormalizedEventSource::set_prefilter(
+    EventHeaderFilterFunc filt) {
+  return weighted->set_prefilter(filt);
+}
+
+void UnweightedNormalizedEventSource::read_ahead(size_t depth) {
+  weighted->read_ahead(depth);
+}
+
+NormInfo UnweightedNormalizedEventSource::norm_info(
+    NuHepMC::CrossSection::Units::Unit const &units) {
+  if (noverweight) {
+    log_debug("[UnweightedNormalizedEventSource]: {}/{} accepted events were "
+              "overweight.",
+              noverweight, naccepted);
+  }
+  return {weighted->norm_info(units).fatx, sumweights, naccepted};
+}
+
+UnweightedNormalizedEventSource::~UnweightedNormalizedEventSource() {}
+
+} // namespace nuis
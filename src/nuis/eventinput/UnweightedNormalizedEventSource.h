@@ -0,0 +1,50 @@
+#pragma once
+
+#include "nuis/eventinput/NormalizedEventSource.h"
+
+#include <cstdint>
+#include <random>
+
+namespace nuis {
+
+/// Accept/reject unweights a NormalizedEventSource against max_weight. Events
+/// are kept with probability |w|/max_weight and returned with a CV weight of
+/// +/-1. Events with |w| > max_weight are always kept and returned with weight
+/// w/max_weight so that the sample stays unbiased.
+///
+/// norm_info reports the FATX of the weighted source, which saw every event,
+/// and the sum of the returned weights, so fatx_per_sumweights normalises the
+/// unweighted sample.
+class UnweightedNormalizedEventSource : public NormalizedEventSource {
+
+  NormalizedEventSourcePtr weighted;
+  double max_weight;
+  uint64_t seed;
+  std::mt19937_64 rng;
+
+  double sumweights;
+  size_t naccepted;
+  size_t noverweight;
+
+  std::vector<EventCVWeightPair> weighted_batch;
+
+  bool accept(EventCVWeightPair &ev);
+  std::optional<EventCVWeightPair>
+  next_accepted(std::optional<EventCVWeightPair> ev);
+
+public:
+  UnweightedNormalizedEventSource(NormalizedEventSourcePtr evs,
+                                  double max_weight, uint64_t seed = 0);
+
+  std::optional<EventCVWeightPair> first();
+  std::optional<EventCVWeightPair> next();
+  size_t next_batch(std::vector<EventCVWeightPair> &batch, size_t n);
+
+  bool set_prefilter(EventHeaderFilterFunc filt);
+  void read_ahead(size_t depth);
+
+  NormInfo norm_info(NuHepMC::CrossSection::Units::Unit const &units);
+  virtual ~UnweightedNormalizedEventSource();
+};
+
+} // namespace nuis
@@ -3,14 +3,18 @@
 #include "nuis/except.h"
 #include "nuis/log.txx"
 
+#include "nuis/eventinput/Fingerprint.h"
 #include "nuis/eventinput/plugins/ROOTUtils.h"
 
+#include "nuis/env.h"
+
 #include "Framework/Conventions/Units.h"
 #include "Framework/EventGen/EventRecord.h"
 #include "Framework/EventGen/GEVGDriver.h"
 #include "Framework/GHEP/GHepParticle.h"
 #include "Framework/GHEP/GHepRecord.h"
 #include "Framework/GHEP/GHepUtils.h"
+#include "Framework/Interaction/Interaction.h"
 #include "Framework/Messenger/Messenger.h"
 #include "Framework/Ntuple/NtpMCEventRecord.h"
 #include "Framework/Numerical/Spline.h"
@@ -38,7 +42,15 @@
 #include "boost/dll/alias.hpp"
 #endif
 
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <set>
+
+#include <unistd.h>
 
 namespace nuis {
 
@@ -457,20 +469,9 @@ std::string GHEPToStr(::genie::GHepRecord const &GHep) {
   return ss.str();
 }
 
-std::shared_ptr<HepMC3::GenEvent> ToGenEvent(genie::GHepRecord const &GHep) {
-
-  auto evt = std::make_shared<HepMC3::GenEvent>(HepMC3::Units::GEV);
-
-  auto proc_id = ConvertGENIEReactionCode(GHep);
-  bool IsNuElectronElastic = (proc_id == 700);
-  ::NuHepMC::ER3::SetProcessID(*evt, proc_id);
-
-  ::NuHepMC::add_attribute(*evt, "GENIE.Resonance",
-                           int(GHep.Summary()->ExclTagPtr()->Resonance()));
-
-  int TargetPDG;
-  bool IsFree;
-
+// Finds the target that GetGENIEParticleStatus should treat as such
+void ResolveTarget(genie::GHepRecord const &GHep, int &TargetPDG,
+                   bool &IsFree) {
   // Set the TargetPDG
   if (GHep.TargetNucleus() != NULL) {
     TargetPDG = GHep.TargetNucleus()->Pdg();
@@ -506,14 +507,31 @@ std::shared_ptr<HepMC3::GenEvent> ToGenEvent(genie::GHepRecord const &GHep) {
       throw FailedGHEPParsing();
     }
   }
+}
+
+std::shared_ptr<HepMC3::GenEvent> ToGenEvent(genie::GHepRecord const &GHep,
+                                             GenEventPool &pool) {
+
+  auto evt = pool.event(HepMC3::Units::GEV);
+
+  auto proc_id = ConvertGENIEReactionCode(GHep);
+  bool IsNuElectronElastic = (proc_id == 700);
+  ::NuHepMC::ER3::SetProcessID(*evt, proc_id);
+
+  ::NuHepMC::add_attribute(*evt, "GENIE.Resonance",
+                           int(GHep.Summary()->ExclTagPtr()->Resonance()));
 
-  auto primary_vtx = std::make_shared<HepMC3::GenVertex>();
+  int TargetPDG;
+  bool IsFree;
+  ResolveTarget(GHep, TargetPDG, IsFree);
+
+  auto primary_vtx = pool.vertex();
   primary_vtx->set_status(::NuHepMC::VertexStatus::Primary);
 
-  auto fsi_vtx = std::make_shared<HepMC3::GenVertex>();
+  auto fsi_vtx = pool.vertex();
   fsi_vtx->set_status(::NuHepMC::VertexStatus::FSISummary);
 
-  auto nucsep_vtx = std::make_shared<HepMC3::GenVertex>();
+  auto nucsep_vtx = pool.vertex();
   nucsep_vtx->set_status(::NuHepMC::VertexStatus::NucleonSeparation);
 
   evt->add_vertex(primary_vtx);
@@ -557,7 +575,7 @@ std::shared_ptr<HepMC3::GenEvent> ToGenEvent(genie::GHepRecord const &GHep) {
 
     auto pid = p.Pdg();
 
-    auto part = std::make_shared<HepMC3::GenParticle>(
+    auto part = pool.particle(
         HepMC3::FourVector{p.Px(), p.Py(), p.Pz(), p.E()}, pid, state);
 
     if (IsPrimaryParticle(p, GHep)) {
@@ -656,8 +674,258 @@ std::shared_ptr<HepMC3::GenEvent> ToGenEvent(genie::GHepRecord const &GHep) {
 
   return evt;
 }
+
+// The status that p is given in the event built by ToGenEvent, or 0 if
+// ToGenEvent does not attach p to the event. has_nucsep_vtx is whether
+// ToGenEvent adds the nucleon separation vertex, which holds the targets and
+// struck nucleons, i.e. whether the event is not NuEEl and has a primary
+// target.
+int KeptParticleStatus(::genie::GHepParticle const &p,
+                       genie::GHepRecord const &GHep, int state,
+                       bool IsNuElectronElastic, bool is_broken_event,
+                       bool has_nucsep_vtx) {
+  if (state == 0) {
+    return 0;
+  }
+
+  bool is_nucleus = (p.Pdg() > 1000000000);
+  int physical_state = is_broken_event
+                           ? ::NuHepMC::ParticleStatus::DocumentationLine
+                           : ::NuHepMC::ParticleStatus::UndecayedPhysical;
+
+  if (IsPrimaryParticle(p, GHep)) {
+    if ((state == ::NuHepMC::ParticleStatus::IncomingBeam) ||
+        (state == ::NuHepMC::ParticleStatus::DocumentationLine)) {
+      return state;
+    } else if (state == ::NuHepMC::ParticleStatus::UndecayedPhysical) {
+      // NuEEl doesn't have a nuclear remnant in the final state
+      return (IsNuElectronElastic && is_nucleus) ? 0 : physical_state;
+    } else if (state == ::NuHepMC::ParticleStatus::Target) {
+      return (has_nucsep_vtx || (IsNuElectronElastic && (p.Pdg() == 11)))
+                 ? state
+                 : 0;
+    } else if (state == ::NuHepMC::ParticleStatus::StruckNucleon) {
+      return has_nucsep_vtx ? state : 0;
+    }
+    return 0;
+  }
+
+  if (is_nucleus) { // nuclear remnant, keeps its status in broken events
+    return has_nucsep_vtx ? state : 0;
+  } else if (state == ::NuHepMC::ParticleStatus::UndecayedPhysical) {
+    return physical_state;
+  }
+  return 0;
+}
+
+// Adds the particles that ToGenEvent would keep to the current table event,
+// in MeV and with the same statuses, but without building any vertices
+void AddToParticleTable(genie::GHepRecord const &GHep, ParticleTable &tbl) {
+  auto proc_id = ConvertGENIEReactionCode(GHep);
+  bool IsNuElectronElastic = (proc_id == 700);
+
+  int TargetPDG;
+  bool IsFree;
+  ResolveTarget(GHep, TargetPDG, IsFree);
+
+  bool is_broken_event = false;
+  bool has_primary_target = false;
+  for (auto const &po : GHep) {
+    ::genie::GHepParticle const &p =
+        dynamic_cast<::genie::GHepParticle const &>(*po);
+    int state = GetGENIEParticleStatus(p, proc_id, TargetPDG, IsFree);
+    if ((state == ::NuHepMC::ParticleStatus::UndecayedPhysical) &&
+        !std::isnormal(p.E()) && !is_broken_event) {
+      is_broken_event = true;
+      log_warn("Broken GHEP3 event encountered.");
+    }
+    if ((state == ::NuHepMC::ParticleStatus::Target) &&
+        IsPrimaryParticle(p, GHep)) {
+      has_primary_target = true;
+    }
+  }
+  bool has_nucsep_vtx = !IsNuElectronElastic && has_primary_target;
+
+  for (auto const &po : GHep) {
+    ::genie::GHepParticle const &p =
+        dynamic_cast<::genie::GHepParticle const &>(*po);
+
+    int state = KeptParticleStatus(
+        p, GHep, GetGENIEParticleStatus(p, proc_id, TargetPDG, IsFree),
+        IsNuElectronElastic, is_broken_event, has_nucsep_vtx);
+    if (state == 0) {
+      continue;
+    }
+
+    tbl.add_particle(p.Pdg(), state, p.Px() * ps::unit::GeV,
+                     p.Py() * ps::unit::GeV, p.Pz() * ps::unit::GeV,
+                     p.E() * ps::unit::GeV);
+  }
+}
 } // namespace ghepconv
 
+namespace {
+// spline cache files hold the magic bytes, the format version, the number of
+// knots and then the knot energies and cross sections as native doubles
+constexpr char const spline_cache_magic[8] = {'N', 'U', 'I', 'S',
+                                               'G', 'S', 'P', 'L'};
+constexpr uint32_t const spline_cache_version = 1;
+
+// $XDG_CACHE_HOME/nuisance/genie_splines, falling back to ~/.cache, as the
+// spline XML often sits on read-only shared storage
+std::string DefaultSplineCacheDir(std::filesystem::path const &spline_xml) {
+  if (auto xdg = std::getenv("XDG_CACHE_HOME"); xdg && xdg[0]) {
+    return (std::filesystem::path(xdg) / "nuisance" / "genie_splines")
+        .native();
+  }
+  if (auto home = std::getenv("HOME"); home && home[0]) {
+    return (std::filesystem::path(home) / ".cache" / "nuisance" /
+            "genie_splines")
+        .native();
+  }
+  return std::filesystem::absolute(spline_xml).parent_path().native();
+}
+} // namespace
+
+std::filesystem::path GHEP3EventSource::SplineCachePath(int tgtpdg,
+                                                        int nupdg) {
+  if (!spline_cache_dir.native().size()) {
+    return {};
+  }
+  return spline_cache_dir /
+         fmt::format("{}.{:016x}.{}_{}.nuisgspl",
+                     std::filesystem::path(SplineXML).stem().native(),
+                     spline_cache_key, nupdg, tgtpdg);
+}
+
+std::unique_ptr<genie::Spline>
+GHEP3EventSource::ReadCachedSpline(int tgtpdg, int nupdg) {
+  auto cache_path = SplineCachePath(tgtpdg, nupdg);
+  if (!cache_path.native().size() || !std::filesystem::exists(cache_path)) {
+    return nullptr;
+  }
+
+  std::ifstream fin(cache_path, std::ios::binary);
+  char magic[8];
+  uint32_t version = 0;
+  uint64_t nknots = 0;
+  fin.read(magic, 8);
+  fin.read(reinterpret_cast<char *>(&version), sizeof(version));
+  fin.read(reinterpret_cast<char *>(&nknots), sizeof(nknots));
+  if (!fin || !std::equal(magic, magic + 8, spline_cache_magic) ||
+      (version != spline_cache_version) || !nknots) {
+    log_warn("Ignoring invalid GENIE spline cache file {}",
+             cache_path.native());
+    return nullptr;
+  }
+
+  std::vector<double> E(nknots), xs(nknots);
+  fin.read(reinterpret_cast<char *>(E.data()), nknots * sizeof(double));
+  fin.read(reinterpret_cast<char *>(xs.data()), nknots * sizeof(double));
+  if (!fin) {
+    log_warn("Ignoring truncated GENIE spline cache file {}",
+             cache_path.native());
+    return nullptr;
+  }
+
+  log_debug("Read XSecSumSpline for nu:{} on tgt:{} from {}", nupdg, tgtpdg,
+            cache_path.native());
+  return std::make_unique<genie::Spline>(int(nknots), E.data(), xs.data());
+}
+
+void GHEP3EventSource::WriteCachedSpline(int tgtpdg, int nupdg,
+                                         genie::Spline const &spline) {
+  auto cache_path = SplineCachePath(tgtpdg, nupdg);
+  if (!cache_path.native().size()) {
+    return;
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(spline_cache_dir, ec);
+  if (ec) {
+    log_warn("Failed to create GENIE spline cache directory {}: {}, splines "
+             "will not be cached.",
+             spline_cache_dir.native(), ec.message());
+    spline_cache_dir.clear();
+    return;
+  }
+
+  uint64_t nknots = spline.NKnots();
+  std::vector<double> E(nknots), xs(nknots);
+  for (uint64_t i = 0; i < nknots; ++i) {
+    spline.GetKnot(int(i), E[i], xs[i]);
+  }
+
+  // write then move so that concurrent jobs never read a partial file
+  auto tmp_path = cache_path;
+  tmp_path +=
+      fmt::format(".{}.{:08x}.tmp", getpid(), std::random_device{}());
+  {
+    std::ofstream fout(tmp_path, std::ios::binary);
+    fout.write(spline_cache_magic, 8);
+    fout.write(reinterpret_cast<char const *>(&spline_cache_version),
+               sizeof(spline_cache_version));
+    fout.write(reinterpret_cast<char const *>(&nknots), sizeof(nknots));
+    fout.write(reinterpret_cast<char const *>(E.data()),
+               nknots * sizeof(double));
+    fout.write(reinterpret_cast<char const *>(xs.data()),
+               nknots * sizeof(double));
+    if (!fout) {
+      log_warn("Failed to write GENIE spline cache file {}, splines will not "
+               "be cached.",
+               tmp_path.native());
+      fout.close();
+      std::filesystem::remove(tmp_path, ec);
+      // don't warn again for every other spline
+      spline_cache_dir.clear();
+      return;
+    }
+  }
+  std::filesystem::rename(tmp_path, cache_path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return;
+  }
+  log_debug("Cached XSecSumSpline for nu:{} on tgt:{} to {}", nupdg, tgtpdg,
+            cache_path.native());
+}
+
+void GHEP3EventSource::LoadSplines() {
+  // tune building and spline loading go through GENIE singletons, which are
+  // shared by every instance of this source, e.g. when sharding an input over
+  // threads
+  static std::mutex spline_load_mutex;
+  // {SplineXML, GENIETune} pairs that have already been loaded
+  static std::set<std::pair<std::string, std::string>> splines_loaded;
+  std::lock_guard<std::mutex> lk(spline_load_mutex);
+
+  if (!SplineXML.size() || !GENIETune.size() ||
+      !splines_loaded.emplace(SplineXML, GENIETune).second) {
+    return;
+  }
+
+  log_debug("GHep3EventSource: SetTuneName({})", GENIETune);
+  genie::RunOpt::Instance()->SetTuneName(GENIETune);
+
+  log_debug("GHep3EventSource: SetEventGeneratorList({})",
+            EventGeneratorListName);
+  genie::RunOpt::Instance()->SetEventGeneratorList(EventGeneratorListName);
+
+  genie::RunOpt::Instance()->BuildTune();
+
+  auto start = std::chrono::steady_clock::now();
+  genie::XmlParserStatus_t ist =
+      genie::XSecSplineList::Instance()->LoadFromXml(SplineXML);
+  if (ist != genie::kXmlOK) {
+    log_warn("genie::XsecSplineList failed to load from {}", SplineXML);
+    return;
+  }
+  log_debug("Loaded GENIE splines from {} in {} ms", SplineXML,
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count());
+}
+
 genie::Spline const *GHEP3EventSource::GetSpline(int tgtpdg, int nupdg) {
   if (!EventGeneratorListName.size()) {
     return nullptr;
@@ -665,7 +933,25 @@ genie::Spline const *GHEP3EventSource::GetSpline(int tgtpdg, int nupdg) {
 
   tgtpdg = (tgtpdg == 2212) ? 1000010010 : tgtpdg;
 
-  if (!EvGens.count(tgtpdg) || !EvGens[tgtpdg].count(nupdg)) {
+  if (EvGens.count(tgtpdg) && EvGens[tgtpdg].count(nupdg)) {
+    return EvGens[tgtpdg][nupdg]->XSecSumSpline();
+  }
+
+  auto &cached = CachedSplines[tgtpdg][nupdg];
+  if (!cached) {
+    cached = ReadCachedSpline(tgtpdg, nupdg);
+  }
+  if (cached) {
+    return cached.get();
+  }
+
+  // only load the full spline XML for splines that are not in the cache
+  LoadSplines();
+
+  {
+    static std::mutex spline_build_mutex;
+    std::lock_guard<std::mutex> lk(spline_build_mutex);
+
     EvGens[tgtpdg][nupdg] = std::make_unique<genie::GEVGDriver>();
     EvGens[tgtpdg][nupdg]->SetEventGeneratorList(EventGeneratorListName);
     EvGens[tgtpdg][nupdg]->Configure(genie::InitialState(tgtpdg, nupdg));
@@ -676,11 +962,21 @@ genie::Spline const *GHEP3EventSource::GetSpline(int tgtpdg, int nupdg) {
         nupdg, tgtpdg, EventGeneratorListName);
   }
 
-  return EvGens[tgtpdg][nupdg]->XSecSumSpline();
+  auto spline = EvGens[tgtpdg][nupdg]->XSecSumSpline();
+  if (spline) {
+    WriteCachedSpline(tgtpdg, nupdg, *spline);
+  }
+  return spline;
 }
 
-GHEP3EventSource::GHEP3EventSource(YAML::Node const &cfg) {
+GHEP3EventSource::GHEP3EventSource(YAML::Node const &cfg)
+    : spline_cache_key{0} {
   log_trace("[GHEP3EventSource] enter");
+  ConfigureROOTThreading(cfg);
+  pool =
+      GenEventPool(cfg["recycle_events"] && cfg["recycle_events"].as<bool>(),
+                   cfg["recycle_pool_size"].as<size_t>(
+                       GenEventPool::default_pool_size));
   if (cfg["filepath"]) {
     log_trace("Checking file {} for tree gtree.",
               cfg["filepath"].as<std::string>());
@@ -700,16 +996,12 @@ GHEP3EventSource::GHEP3EventSource(YAML::Node const &cfg) {
     log_trace("[GHEP3EventSource] exit");
   }
 
-  auto evt = first();
-  if (!evt) { // if we can't read an event, there's no point going further
+  if (!filepaths.size()) { // no point going further
     return;
   }
 
   genie::Messenger::Instance()->SetPriorityLevel("GHepUtils", pFATAL);
 
-  genie::XSecSplineList *splist = genie::XSecSplineList::Instance();
-
-  std::string SplineXML;
   if (cfg["spline_file"]) {
     SplineXML = cfg["spline_file"].as<std::string>();
   } else if (std::getenv("GENIE_XSEC_FILE")) {
@@ -723,7 +1015,6 @@ GHEP3EventSource::GHEP3EventSource(YAML::Node const &cfg) {
     return;
   }
 
-  std::string GENIETune;
   if (cfg["tune"]) {
     GENIETune = cfg["tune"].as<std::string>();
   } else if (std::getenv("GENIE_XSEC_TUNE")) {
@@ -736,32 +1027,36 @@ GHEP3EventSource::GHEP3EventSource(YAML::Node const &cfg) {
     return;
   }
 
-  log_debug("GHep3EventSource: SetTuneName({})", GENIETune);
-  genie::RunOpt::Instance()->SetTuneName(GENIETune);
-
   if (cfg["event-generator-list"]) {
     EventGeneratorListName = cfg["event-generator-list"].as<std::string>();
   } else if (std::getenv("GENIE_XSEC_EVENTGENERATORLIST")) {
     EventGeneratorListName = std::getenv("GENIE_XSEC_EVENTGENERATORLIST");
   }
 
-  log_debug("GHep3EventSource: SetEventGeneratorList({})",
-            EventGeneratorListName);
-  genie::RunOpt::Instance()->SetEventGeneratorList(EventGeneratorListName);
-
-  genie::RunOpt::Instance()->BuildTune();
-
-  genie::XmlParserStatus_t ist = splist->LoadFromXml(SplineXML);
-  if (ist != genie::kXmlOK) {
-    log_warn("genie::XsecSplineList failed to load from {}", SplineXML);
-    return;
+  // The spline XML is only loaded when a spline is needed that is not in the
+  // spline cache, which is written to spline_cache_dir if set, then
+  // $NUISANCE_GENIE_SPLINE_CACHE_DIR, and otherwise the user cache directory.
+  // spline_cache: false disables it.
+  auto xml_fingerprint = FileFingerprint(SplineXML);
+  if (cfg["spline_cache"].as<bool>(true) && xml_fingerprint.size()) {
+    spline_cache_dir =
+        cfg["spline_cache_dir"]
+            ? cfg["spline_cache_dir"].as<std::string>()
+            : env::NUISANCE_GENIE_SPLINE_CACHE_DIR(
+                  DefaultSplineCacheDir(SplineXML));
+    spline_cache_key = StableHash(
+        fmt::format("{};{};{};{}", xml_fingerprint, GENIETune,
+                    EventGeneratorListName, GENIE_VERSION_STR));
   }
 }
 
-std::shared_ptr<HepMC3::GenEvent> GHEP3EventSource::first() {
+bool GHEP3EventSource::open() {
+  if (chin) { // already opened
+    return ch_ents > 0;
+  }
 
   if (!filepaths.size()) {
-    return nullptr;
+    return false;
   }
 
   chin = std::make_unique<TChain>("gtree");
@@ -770,7 +1065,7 @@ std::shared_ptr<HepMC3::GenEvent> GHEP3EventSource::first() {
     if (!chin->Add(ftr.c_str(), 0)) {
       log_warn("Could not find gtree in {}", ftr.native());
       chin.reset();
-      return nullptr;
+      return false;
     }
   }
 
@@ -778,7 +1073,7 @@ std::shared_ptr<HepMC3::GenEvent> GHEP3EventSource::first() {
   ient = 0;
 
   if (ch_ents == 0) {
-    return nullptr;
+    return false;
   }
 
   ntpl = NULL;
@@ -788,37 +1083,26 @@ std::shared_ptr<HepMC3::GenEvent> GHEP3EventSource::first() {
   chin->GetEntry(0);
 
   ch_fuid = chin->GetFile()->GetUUID();
-  ient = 0;
+
+  // the run info depends on whether we have a total cross section spline for
+  // the probe and target of the first event
   auto ge = ghepconv::ToGenEvent(
-      static_cast<genie::GHepRecord const &>(*ntpl->event));
+      static_cast<genie::GHepRecord const &>(*ntpl->event), pool);
 
   auto tpart = NuHepMC::Event::GetTargetParticle(*ge);
   auto bpart = NuHepMC::Event::GetBeamParticle(*ge);
 
-  auto xspline = GetSpline(tpart->pid(), bpart->pid());
-
-  gri = ghepconv::BuildRunInfo(xspline);
-
-  ge->set_event_number(ient);
-  ge->set_run_info(gri);
-  ge->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
+  gri = ghepconv::BuildRunInfo(GetSpline(tpart->pid(), bpart->pid()));
+  return true;
+}
 
-  if (xspline) {
-    auto xs = xspline->Evaluate(bpart->momentum().e() / ps::unit::GeV) /
-              genie::units::pb;
-    if (!std::isnormal(xs)) {
-      log_debug("xs(E = {}, probe = {}, tgt = {}) = {}",
-                bpart->momentum().e() / ps::unit::GeV, bpart->pid(),
-                tpart->pid(), xs);
-    } else {
-      NUIS_LOG_TRACE("xs(E = {}, probe = {}, tgt = {}) = {}",
-                     bpart->momentum().e() / ps::unit::GeV, bpart->pid(),
-                     tpart->pid(), xs);
-    }
-    NuHepMC::EC2::SetTotalCrossSection(*ge, xs); // in GeV
+std::shared_ptr<HepMC3::GenEvent> GHEP3EventSource::first() {
+  if (!open()) {
+    return nullptr;
   }
-
-  return ge;
+  // rewind, next() pre-increments
+  ient = -1;
+  return next();
 }
 
 std::shared_ptr<HepMC3::GenEvent> GHEP3EventSource::next() {
@@ -835,36 +1119,138 @@ std::shared_ptr<HepMC3::GenEvent> GHEP3EventSource::next() {
     ch_fuid = chin->GetFile()->GetUUID();
   }
 
+  if (prefilter) {
+    auto hdr = header();
+    if (!prefilter(hdr)) {
+      auto stub = MakePrefilteredStub(gri, ient);
+      SetTotalCrossSection(*stub, hdr.target_pdg, hdr.probe_pdg,
+                           hdr.probe_energy);
+      return stub;
+    }
+  }
+
   auto ge = ghepconv::ToGenEvent(
-      static_cast<genie::GHepRecord const &>(*ntpl->event));
+      static_cast<genie::GHepRecord const &>(*ntpl->event), pool);
   ge->set_event_number(ient);
   ge->set_run_info(gri);
   ge->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
   auto tpart = NuHepMC::Event::GetTargetParticle(*ge);
   auto bpart = NuHepMC::Event::GetBeamParticle(*ge);
 
-  auto xspline = GetSpline(tpart->pid(), bpart->pid());
-  if (xspline) {
-    auto xs = xspline->Evaluate(bpart->momentum().e() / ps::unit::GeV) /
-              genie::units::pb;
-    if (!std::isnormal(xs)) {
-      log_debug("xs(E = {}, probe = {}, tgt = {}) = {}",
-                bpart->momentum().e() / ps::unit::GeV, bpart->pid(),
-                tpart->pid(), xs);
-    } else {
-      NUIS_LOG_TRACE("xs(E = {}, probe = {}, tgt = {}) = {}",
-                     bpart->momentum().e() / ps::unit::GeV, bpart->pid(),
-                     tpart->pid(), xs);
-    }
-    NuHepMC::EC2::SetTotalCrossSection(*ge, xs); // in GeV
-  }
+  SetTotalCrossSection(*ge, tpart->pid(), bpart->pid(), bpart->momentum().e());
   return ge;
 }
 
+double GHEP3EventSource::TotalCrossSection(int tgtpdg, int nupdg,
+                                           double nu_E) {
+  auto xspline = GetSpline(tgtpdg, nupdg);
+  if (!xspline) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  auto xs = xspline->Evaluate(nu_E / ps::unit::GeV) / genie::units::pb;
+  if (!std::isnormal(xs)) {
+    log_debug("xs(E = {}, probe = {}, tgt = {}) = {}", nu_E / ps::unit::GeV,
+              nupdg, tgtpdg, xs);
+  } else {
+    NUIS_LOG_TRACE("xs(E = {}, probe = {}, tgt = {}) = {}",
+                   nu_E / ps::unit::GeV, nupdg, tgtpdg, xs);
+  }
+  return xs;
+}
+
+void GHEP3EventSource::SetTotalCrossSection(HepMC3::GenEvent &ge, int tgtpdg,
+                                            int nupdg, double nu_E) {
+  auto xs = TotalCrossSection(tgtpdg, nupdg, nu_E);
+  if (std::isnan(xs)) { // no spline
+    return;
+  }
+  NuHepMC::EC2::SetTotalCrossSection(ge, xs); // in GeV
+}
+
+EventHeader GHEP3EventSource::header() {
+  auto const &GHep = static_cast<genie::GHepRecord const &>(*ntpl->event);
+  auto const &init_state = GHep.Summary()->InitState();
+
+  EventHeader hdr{0, 0, 0, 0, 0};
+  hdr.process_id = ghepconv::ConvertGENIEReactionCode(GHep);
+  hdr.native_mode = ::genie::utils::ghep::NeutReactionCode(&GHep);
+  hdr.probe_pdg = init_state.ProbePdg();
+  hdr.probe_energy = init_state.ProbeE(genie::kRfLab) * ps::unit::GeV;
+
+  // match the target particle that ghepconv::ToGenEvent would pick
+  if (hdr.process_id == 700) { // NuElectronElastic
+    hdr.target_pdg = 11;
+  } else if (GHep.TargetNucleus()) {
+    hdr.target_pdg = GHep.TargetNucleus()->Pdg();
+  } else {
+    hdr.target_pdg = GHep.Particle(1)->Pdg();
+  }
+  return hdr;
+}
+
+void GHEP3EventSource::fill_table_event(ParticleTable &tbl) {
+  auto hdr = header();
+  tbl.add_event(
+      ient, hdr, 1,
+      TotalCrossSection(hdr.target_pdg, hdr.probe_pdg, hdr.probe_energy));
+  // rejected entries keep their place in the table, but get no particles
+  if (prefilter && !prefilter(hdr)) {
+    return;
+  }
+  ghepconv::AddToParticleTable(
+      static_cast<genie::GHepRecord const &>(*ntpl->event), tbl);
+}
+
+size_t GHEP3EventSource::first_table(ParticleTable &tbl, size_t n) {
+  tbl.clear();
+  if (!open()) {
+    return 0;
+  }
+  // rewind, next_table() pre-increments
+  ient = -1;
+  return next_table(tbl, n);
+}
+
+size_t GHEP3EventSource::next_table(ParticleTable &tbl, size_t n) {
+  tbl.clear();
+  while ((tbl.nevents() < n) && ((ient + 1) < ch_ents)) {
+    ntpl->Clear(); // this stops catastrophic memory leaks
+    chin->GetEntry(++ient);
+    fill_table_event(tbl);
+  }
+  return tbl.nevents();
+}
+
+bool GHEP3EventSource::set_prefilter(EventHeaderFilterFunc filt) {
+  prefilter = filt;
+  return true;
+}
+
+size_t GHEP3EventSource::size() {
+  if (!chin) {
+    return 0;
+  }
+  return size_t(ch_ents);
+}
+
+bool GHEP3EventSource::seek(size_t entry) {
+  if (!open()) {
+    return false;
+  }
+  if (Long64_t(entry) >= ch_ents) {
+    return false;
+  }
+  // next() pre-increments
+  ient = Long64_t(entry) - 1;
+  return true;
+}
+
 genie::EventRecord const *
 GHEP3EventSource::EventRecord(HepMC3::GenEvent const &ev) {
   auto ev_num = ev.event_number();
-  if (ev_num != ient) { // don't read off disk if we don't need to
+  // don't read off disk if we don't need to, compare against what the chain
+  // last read rather than ient, which may have been moved by seek()
+  if (ev_num != chin->GetReadEntry()) {
     ntpl->Clear();
     chin->GetEntry(ev_num);
   }
@@ -874,10 +1260,14 @@ GHEP3EventSource::EventRecord(HepMC3::GenEvent const &ev) {
 IEventSourcePtr GHEP3EventSource::MakeEventSource(YAML::Node const &cfg) {
   return std::make_shared<GHEP3EventSource>(cfg);
 }
+bool GHEP3EventSource::CanReadFile(std::filesystem::path const &filepath) {
+  return IsROOTFileWithTTree(filepath, "gtree");
+}
 GHEP3EventSource::~GHEP3EventSource() {}
 
 #ifdef NUISANCE_USE_BOOSTDLL
 BOOST_DLL_ALIAS(nuis::GHEP3EventSource::MakeEventSource, MakeEventSource);
+BOOST_DLL_ALIAS(nuis::GHEP3EventSource::CanReadFile, CanReadFile);
 #endif
 
 } // namespace nuis
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "nuis/eventinput/GenEventPool.h"
 #include "nuis/eventinput/IEventSource.h"
+#include "nuis/eventinput/ParticleTable.h"
 
 #include "TChain.h"
 
@@ -23,7 +25,8 @@ class Spline;
 
 namespace nuis {
 
-class GHEP3EventSource : public IEventSource {
+class GHEP3EventSource : public IEventSource,
+                         public IParticleTableSource {
 
   std::vector<std::filesystem::path> filepaths;
   std::unique_ptr<TChain> chin;
@@ -36,12 +39,40 @@ class GHEP3EventSource : public IEventSource {
 
   genie::NtpMCEventRecord *ntpl;
 
+  GenEventPool pool;
+
+  std::string SplineXML;
+  std::string GENIETune;
   std::string EventGeneratorListName;
+
   std::unordered_map<
       int, std::unordered_map<int, std::unique_ptr<genie::GEVGDriver>>>
       EvGens;
 
+  // XSecSumSplines read back from the spline cache, keyed like EvGens
+  std::unordered_map<int,
+                     std::unordered_map<int, std::unique_ptr<genie::Spline>>>
+      CachedSplines;
+  std::filesystem::path spline_cache_dir;
+  uint64_t spline_cache_key;
+
+  std::filesystem::path SplineCachePath(int tgtpdg, int nupdg);
+  std::unique_ptr<genie::Spline> ReadCachedSpline(int tgtpdg, int nupdg);
+  void WriteCachedSpline(int tgtpdg, int nupdg, genie::Spline const &spline);
+
   genie::Spline const *GetSpline(int tgtpdg, int nupdg);
+  // in pb, NaN if there is no spline for this probe and target
+  double TotalCrossSection(int tgtpdg, int nupdg, double nu_E);
+  void SetTotalCrossSection(HepMC3::GenEvent &ge, int tgtpdg, int nupdg,
+                            double nu_E);
+
+  EventHeaderFilterFunc prefilter;
+  EventHeader header();
+
+  void fill_table_event(ParticleTable &tbl);
+
+  // builds the chain and run info, only does work on the first call
+  bool open();
 
 public:
   GHEP3EventSource(YAML::Node const &cfg);
@@ -50,10 +81,31 @@ public:
 
   std::shared_ptr<HepMC3::GenEvent> next();
 
+  // rejected entries still get the E.C.2 total cross section, which needs the
+  // splines for their probe and target
+  bool set_prefilter(EventHeaderFilterFunc filt);
+
+  // table events carry the spline total cross section, the particles are
+  // those ToGenEvent keeps, with their NuHepMC statuses
+  size_t first_table(ParticleTable &tbl, size_t n);
+  size_t next_table(ParticleTable &tbl, size_t n);
+  std::shared_ptr<HepMC3::GenRunInfo> run_info() { return gri; }
+
+  bool seekable() { return true; }
+  size_t size();
+  bool seek(size_t entry);
+
   static IEventSourcePtr MakeEventSource(YAML::Node const &cfg);
+  static bool CanReadFile(std::filesystem::path const &filepath);
 
   genie::EventRecord const *EventRecord(HepMC3::GenEvent const &ev);
 
+  // Builds the GENIE tune and loads the spline XML, only does work on the
+  // first call. Splines are otherwise loaded lazily, on the first total cross
+  // section that is not in the spline cache, but reweighting needs the full
+  // GENIE configuration.
+  void LoadSplines();
+
   virtual ~GHEP3EventSource();
 };
 
@@ -1,7 +1,9 @@
 #include "nuis/except.h"
 #include "nuis/log.txx"
 
+#include "nuis/eventinput/GenEventPool.h"
 #include "nuis/eventinput/IEventSource.h"
+#include "nuis/eventinput/ParticleTable.h"
 
 #include "nuis/eventinput/plugins/ROOTUtils.h"
 
@@ -253,7 +255,8 @@ BuildRunInfo(double fatx, int probepid,
   return run_info;
 }
 
-class NUISANCE2FlatTreeEventSource : public IEventSource {
+class NUISANCE2FlatTreeEventSource : public IEventSource,
+                                     public IParticleTableSource {
 
   std::vector<std::filesystem::path> filepaths;
   std::unique_ptr<TChain> chin;
@@ -261,10 +264,38 @@ class NUISANCE2FlatTreeEventSource : public IEventSource {
   std::shared_ptr<HepMC3::GenRunInfo> gri;
 
   Long64_t ient;
+  // set by seek(), the next call to next() jumps here instead of stepping
+  Long64_t seek_entry;
   double fatx;
 
   std::unique_ptr<TTreeReader> reader;
 
+  // which optional particle blocks are read, set by the content: key. The
+  // initial state block is always read as it defines the beam and target.
+  bool read_final_state;
+  bool read_vertex;
+
+  std::vector<std::string> EnabledBranches() {
+    std::vector<std::string> branches = {
+        "fScaleFactor", "InputWeight", "Mode",    "PDGnu",
+        "tgt",          "tgta",        "tgtz",    "ninitp",
+        "px_init",      "py_init",     "pz_init", "E_init",
+        "pdg_init",
+    };
+    if (read_final_state) {
+      for (auto b : {"nfsp", "px", "py", "pz", "E", "pdg"}) {
+        branches.push_back(b);
+      }
+    }
+    if (read_vertex) {
+      for (auto b :
+           {"nvertp", "px_vert", "py_vert", "pz_vert", "E_vert", "pdg_vert"}) {
+        branches.push_back(b);
+      }
+    }
+    return branches;
+  }
+
   std::unique_ptr<TTreeReaderValue<int>> nfsp;
   std::unique_ptr<TTreeReaderArray<float>> px;
   std::unique_ptr<TTreeReaderArray<float>> py;
@@ -296,33 +327,104 @@ class NUISANCE2FlatTreeEventSource : public IEventSource {
   std::unique_ptr<TTreeReaderValue<int>> tgta;
   std::unique_ptr<TTreeReaderValue<int>> tgtz;
 
+  GenEventPool pool;
+
+  EventHeaderFilterFunc prefilter;
+
+  int TargetPDG() {
+    return ((**tgtz) > 0) && ((**tgta) > 0)
+               ? NuHepMC::CrossSection::Units::NuclearPDG(**tgtz, **tgta)
+               : (**tgt);
+  }
+
+  EventHeader header() {
+    EventHeader hdr{0, 0, 0, 0, 0};
+    hdr.process_id = GetEC1Channel(**Mode);
+    hdr.native_mode = **Mode;
+    hdr.probe_pdg = **PDGnu;
+    for (int in_it = 0; in_it < **ninitp; ++in_it) {
+      if (pdg_init->operator[](in_it) == **PDGnu) {
+        hdr.probe_energy = E_init->operator[](in_it) * 1E3; // GeV -> MeV
+        break;
+      }
+    }
+    hdr.target_pdg = TargetPDG();
+    return hdr;
+  }
+
+  // the CV weight that ToGenEvent would give this entry, without building it
+  double StubWeight() {
+    auto tgtpid = TargetPDG();
+    // ToGenEvent makes up a nuclear target if it can't find one
+    bool has_tgt = tgtpid > 1000000000;
+    bool has_beam = false;
+    for (int in_it = 0; in_it < **ninitp; ++in_it) {
+      auto pid = pdg_init->operator[](in_it);
+      has_beam = has_beam || (pid == **PDGnu);
+      has_tgt = has_tgt || (pid == tgtpid);
+    }
+    bool has_fs = !read_final_state || ((**nfsp) > 0);
+    return (has_beam && has_tgt && has_fs) ? **InputWeight : 0;
+  }
+
+  // accounts for per-file variations over an input chain
+  double FileWeightScale() {
+    return *(*fScaleFactor) * double(reader->GetEntries()) * 1E38 / fatx;
+  }
+
+  // the status of an initial state particle, 0 if it is neither the beam,
+  // target nor struck nucleon
+  int InitialStateStatus(int pid, int tgtpid) {
+    if (pid == **PDGnu) {
+      return NuHepMC::ParticleStatus::IncomingBeam;
+    }
+    // looking for struck nucleon/target nucleus
+    // if the tgt is a nuclear code for hydrogen
+    if (tgtpid == 1000010010) { // hydrogen/proton
+      if ((pid == 2212) || (pid == tgtpid)) {
+        return NuHepMC::ParticleStatus::Target;
+      }
+    } else if (tgtpid == 1000000010) { // free nucleon
+      if ((pid == 2112) || (pid == tgtpid)) {
+        return NuHepMC::ParticleStatus::Target;
+      }
+      // otherwise assume we have a bigger nucleus and can build the target
+      // nuclear particle and maybe struck nucleon
+    } else {
+      if (pid == tgtpid) {
+        return NuHepMC::ParticleStatus::Target;
+      } else if ((pid == 2212) || (pid == 2112)) {
+        return NuHepMC::ParticleStatus::StruckNucleon;
+      }
+    }
+    return 0;
+  }
+
   std::shared_ptr<HepMC3::GenEvent> ToGenEvent() {
-    auto evt = std::make_shared<HepMC3::GenEvent>(HepMC3::Units::GEV);
+    auto evt = pool.event(HepMC3::Units::GEV);
 
     NuHepMC::ER3::SetProcessID(*evt, GetEC1Channel(**Mode));
 
-    auto primary_vtx = std::make_shared<HepMC3::GenVertex>();
+    auto primary_vtx = pool.vertex();
     primary_vtx->set_status(NuHepMC::VertexStatus::Primary);
 
-    auto nucleon_separation_vtx = std::make_shared<HepMC3::GenVertex>();
+    auto nucleon_separation_vtx = pool.vertex();
     nucleon_separation_vtx->set_status(
         NuHepMC::VertexStatus::NucleonSeparation);
 
-    auto fsi_vtx = std::make_shared<HepMC3::GenVertex>();
+    auto fsi_vtx = pool.vertex();
     fsi_vtx->set_status(NuHepMC::VertexStatus::FSISummary);
 
     evt->add_vertex(primary_vtx);
     evt->add_vertex(fsi_vtx);
 
-    auto tgtpid = ((**tgtz) > 0) && ((**tgta) > 0)
-                      ? NuHepMC::CrossSection::Units::NuclearPDG(**tgtz, **tgta)
-                      : (**tgt);
+    auto tgtpid = TargetPDG();
 
-    for (int fs_it = 0; fs_it < **nfsp; ++fs_it) {
+    for (int fs_it = 0; read_final_state && (fs_it < **nfsp); ++fs_it) {
 
       auto pid = pdg->operator[](fs_it);
 
-      auto part = std::make_shared<HepMC3::GenParticle>(
+      auto part = pool.particle(
           HepMC3::FourVector{px->operator[](fs_it), py->operator[](fs_it),
                              pz->operator[](fs_it), E->operator[](fs_it)},
           pid, NuHepMC::ParticleStatus::UndecayedPhysical);
@@ -337,38 +439,20 @@ class NUISANCE2FlatTreeEventSource : public IEventSource {
 
       auto pid = pdg_init->operator[](in_it);
 
-      auto part = std::make_shared<HepMC3::GenParticle>(
+      auto part = pool.particle(
           HepMC3::FourVector{
               px_init->operator[](in_it), py_init->operator[](in_it),
               pz_init->operator[](in_it), E_init->operator[](in_it)},
           pid, 0);
 
-      if (pid == **PDGnu) {
-        part->set_status(NuHepMC::ParticleStatus::IncomingBeam);
+      auto status = InitialStateStatus(pid, tgtpid);
+      part->set_status(status);
+      if (status == NuHepMC::ParticleStatus::IncomingBeam) {
         primary_vtx->add_particle_in(part);
-      } else { // looking for struck nucleon/target nucleus
-        // if the tgt is a nuclear code for hydrogen
-        if (tgtpid == 1000010010) { // hydrogen/proton
-          if ((pid == 2212) || (pid == tgtpid)) {
-            part->set_status(NuHepMC::ParticleStatus::Target);
-            tgt_part = part;
-          }
-        } else if (tgtpid == 1000000010) { // free nucleon
-          if ((pid == 2112) || (pid == tgtpid)) {
-            part->set_status(NuHepMC::ParticleStatus::Target);
-            tgt_part = part;
-          }
-          // otherwise assume we have a bigger nucleus and can build the target
-          // nuclear particle and maybe struck nucleon
-        } else {
-          if (pid == tgtpid) {
-            part->set_status(NuHepMC::ParticleStatus::Target);
-            tgt_part = part;
-          } else if ((pid == 2212) || (pid == 2112)) {
-            part->set_status(NuHepMC::ParticleStatus::StruckNucleon);
-            struck_nuc_part = part;
-          }
-        }
+      } else if (status == NuHepMC::ParticleStatus::Target) {
+        tgt_part = part;
+      } else if (status == NuHepMC::ParticleStatus::StruckNucleon) {
+        struck_nuc_part = part;
       }
     }
 
@@ -382,11 +466,11 @@ class NUISANCE2FlatTreeEventSource : public IEventSource {
     }
 
     // skip ninitp as they are in both array
-    for (int vt_it = **ninitp; vt_it < **nvertp; ++vt_it) {
+    for (int vt_it = **ninitp; read_vertex && (vt_it < **nvertp); ++vt_it) {
 
       auto pid = pdg_vert->operator[](vt_it);
 
-      auto part = std::make_shared<HepMC3::GenParticle>(
+      auto part = pool.particle(
           HepMC3::FourVector{
               px_vert->operator[](vt_it), py_vert->operator[](vt_it),
               pz_vert->operator[](vt_it), E_vert->operator[](vt_it)},
@@ -409,7 +493,7 @@ class NUISANCE2FlatTreeEventSource : public IEventSource {
     if (!tgtp) {
       if (tgtpid > 1000000000) {
         // hack in a dummy nuclear particle because I can't even
-        primary_vtx->add_particle_in(std::make_shared<HepMC3::GenParticle>(
+        primary_vtx->add_particle_in(pool.particle(
             HepMC3::FourVector{}, tgtpid, NuHepMC::ParticleStatus::Target));
 
         tgtp = NuHepMC::Event::GetTargetParticle(*evt);
@@ -419,12 +503,14 @@ class NUISANCE2FlatTreeEventSource : public IEventSource {
                   **tgt, **tgta, **tgtz);
       }
     }
-    if (!nfs) {
+    // without the final state block there is nothing to check
+    bool missing_fs = read_final_state && !nfs;
+    if (missing_fs) {
       log_debug("NUISANCE2FlatTree event contained no final state particles, "
                 "giving a weight of 0.");
     }
 
-    if ((!beamp) || (!tgtp) || (!nfs)) {
+    if ((!beamp) || (!tgtp) || missing_fs) {
       evt->weights().push_back(0);
     } else {
       evt->weights().push_back(**InputWeight);
@@ -435,9 +521,79 @@ class NUISANCE2FlatTreeEventSource : public IEventSource {
     return evt;
   }
 
+  // adds the current entry to tbl with the particles that ToGenEvent would
+  // build, rejected entries get no particles
+  void FillTableEvent(ParticleTable &tbl) {
+    auto hdr = header();
+    tbl.add_event(ient, hdr, StubWeight() * FileWeightScale());
+    if (prefilter && !prefilter(hdr)) {
+      return;
+    }
+
+    for (int fs_it = 0; read_final_state && (fs_it < **nfsp); ++fs_it) {
+      tbl.add_particle(pdg->operator[](fs_it),
+                       NuHepMC::ParticleStatus::UndecayedPhysical,
+                       px->operator[](fs_it) * 1E3, py->operator[](fs_it) * 1E3,
+                       pz->operator[](fs_it) * 1E3, E->operator[](fs_it) * 1E3);
+    }
+
+    auto tgtpid = TargetPDG();
+    bool has_tgt = false;
+    for (int in_it = 0; in_it < **ninitp; ++in_it) {
+      auto pid = pdg_init->operator[](in_it);
+      auto status = InitialStateStatus(pid, tgtpid);
+      if (!status) {
+        continue;
+      }
+      has_tgt = has_tgt || (status == NuHepMC::ParticleStatus::Target);
+      tbl.add_particle(
+          pid, status, px_init->operator[](in_it) * 1E3,
+          py_init->operator[](in_it) * 1E3, pz_init->operator[](in_it) * 1E3,
+          E_init->operator[](in_it) * 1E3);
+    }
+    if (!has_tgt && (tgtpid > 1000000000)) { // as ToGenEvent
+      tbl.add_particle(tgtpid, NuHepMC::ParticleStatus::Target, 0, 0, 0, 0);
+    }
+
+    for (int vt_it = **ninitp; read_vertex && (vt_it < **nvertp); ++vt_it) {
+      tbl.add_particle(
+          pdg_vert->operator[](vt_it),
+          NuHepMC::ParticleStatus::DocumentationLine,
+          px_vert->operator[](vt_it) * 1E3, py_vert->operator[](vt_it) * 1E3,
+          pz_vert->operator[](vt_it) * 1E3, E_vert->operator[](vt_it) * 1E3);
+    }
+  }
+
 public:
   NUISANCE2FlatTreeEventSource(YAML::Node const &cfg) {
     log_trace("[NUISANCE2FlatTreeEventSource] enter");
+    ConfigureROOTThreading(cfg);
+
+    read_final_state = true;
+    read_vertex = true;
+    if (cfg["content"]) {
+      read_final_state = false;
+      read_vertex = false;
+      for (auto const &block : cfg["content"].as<std::vector<std::string>>()) {
+        if (block == "final_state") {
+          read_final_state = true;
+        } else if (block == "vertex") {
+          read_vertex = true;
+        } else if (block != "initial_state") {
+          log_warn("[NUISANCE2FlatTreeEventSource]: Ignoring unknown content "
+                   "block {}, expected one of final_state, initial_state or "
+                   "vertex.",
+                   block);
+        }
+      }
+      log_debug("[NUISANCE2FlatTreeEventSource]: reading final state: {}, "
+                "vertex: {}",
+                read_final_state, read_vertex);
+    }
+
+    pool = GenEventPool(
+        cfg["recycle_events"] && cfg["recycle_events"].as<bool>(),
+        cfg["recycle_pool_size"].as<size_t>(GenEventPool::default_pool_size));
     if (cfg["filepath"]) {
       log_trace("Checking file {} for tree FlatTree_VARS.",
                 cfg["filepath"].as<std::string>());
@@ -458,10 +614,15 @@ public:
     log_trace("[NUISANCE2FlatTreeEventSource] exit");
   }
 
-  std::shared_ptr<HepMC3::GenEvent> first() {
+  // builds the chain, branch readers and run info, only does work on the
+  // first call
+  bool open() {
+    if (reader) { // already opened
+      return bool(gri);
+    }
 
     if (!filepaths.size()) {
-      return nullptr;
+      return false;
     }
 
     chin = std::make_unique<TChain>("FlatTree_VARS");
@@ -470,22 +631,30 @@ public:
       if (!chin->Add(ftr.c_str(), 0)) {
         log_warn("Could not find FlatTree_VARS in {}", ftr.native());
         chin.reset();
-        return nullptr;
+        return false;
       }
     }
 
+    // disabled branches are neither read nor cached
+    chin->SetBranchStatus("*", false);
+    for (auto const &b : EnabledBranches()) {
+      chin->SetBranchStatus(b.c_str(), true);
+    }
+
     reader = std::make_unique<TTreeReader>(chin.get());
 
     if (reader->GetEntries() == 0) {
-      return nullptr;
+      return false;
     }
 
-    nfsp = std::make_unique<TTreeReaderValue<int>>(*reader, "nfsp");
-    px = std::make_unique<TTreeReaderArray<float>>(*reader, "px");
-    py = std::make_unique<TTreeReaderArray<float>>(*reader, "py");
-    pz = std::make_unique<TTreeReaderArray<float>>(*reader, "pz");
-    E = std::make_unique<TTreeReaderArray<float>>(*reader, "E");
-    pdg = std::make_unique<TTreeReaderArray<int>>(*reader, "pdg");
+    if (read_final_state) {
+      nfsp = std::make_unique<TTreeReaderValue<int>>(*reader, "nfsp");
+      px = std::make_unique<TTreeReaderArray<float>>(*reader, "px");
+      py = std::make_unique<TTreeReaderArray<float>>(*reader, "py");
+      pz = std::make_unique<TTreeReaderArray<float>>(*reader, "pz");
+      E = std::make_unique<TTreeReaderArray<float>>(*reader, "E");
+      pdg = std::make_unique<TTreeReaderArray<int>>(*reader, "pdg");
+    }
 
     ninitp = std::make_unique<TTreeReaderValue<int>>(*reader, "ninitp");
     px_init = std::make_unique<TTreeReaderArray<float>>(*reader, "px_init");
@@ -494,12 +663,14 @@ public:
     E_init = std::make_unique<TTreeReaderArray<float>>(*reader, "E_init");
     pdg_init = std::make_unique<TTreeReaderArray<int>>(*reader, "pdg_init");
 
-    nvertp = std::make_unique<TTreeReaderValue<int>>(*reader, "nvertp");
-    px_vert = std::make_unique<TTreeReaderArray<float>>(*reader, "px_vert");
-    py_vert = std::make_unique<TTreeReaderArray<float>>(*reader, "py_vert");
-    pz_vert = std::make_unique<TTreeReaderArray<float>>(*reader, "pz_vert");
-    E_vert = std::make_unique<TTreeReaderArray<float>>(*reader, "E_vert");
-    pdg_vert = std::make_unique<TTreeReaderArray<int>>(*reader, "pdg_vert");
+    if (read_vertex) {
+      nvertp = std::make_unique<TTreeReaderValue<int>>(*reader, "nvertp");
+      px_vert = std::make_unique<TTreeReaderArray<float>>(*reader, "px_vert");
+      py_vert = std::make_unique<TTreeReaderArray<float>>(*reader, "py_vert");
+      pz_vert = std::make_unique<TTreeReaderArray<float>>(*reader, "pz_vert");
+      E_vert = std::make_unique<TTreeReaderArray<float>>(*reader, "E_vert");
+      pdg_vert = std::make_unique<TTreeReaderArray<int>>(*reader, "pdg_vert");
+    }
 
     fScaleFactor =
         std::make_unique<TTreeReaderValue<double>>(*reader, "fScaleFactor");
@@ -512,10 +683,8 @@ public:
     tgtz = std::make_unique<TTreeReaderValue<int>>(*reader, "tgtz");
     PDGnu = std::make_unique<TTreeReaderValue<int>>(*reader, "PDGnu");
 
-    ient = 0;
-
     if (!reader->Next()) {
-      return nullptr;
+      return false;
     }
 
     auto ge = ToGenEvent();
@@ -529,34 +698,115 @@ public:
     fatx = *(*fScaleFactor) * double(reader->GetEntries()) * 1E38;
     gri = BuildRunInfo(fatx, NuHepMC::Event::GetBeamParticle(*ge)->pid(), flux);
 
-    ge->set_event_number(ient++);
-    ge->set_run_info(gri);
-    ge->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
+    return true;
+  }
 
-    return ge;
+  std::shared_ptr<HepMC3::GenEvent> first() {
+    if (!open()) {
+      return nullptr;
+    }
+
+    reader->Restart();
+    ient = 0;
+    seek_entry = -1;
+
+    return next();
   }
 
   std::shared_ptr<HepMC3::GenEvent> next() {
 
-    if (!reader->Next()) {
+    if (seek_entry >= 0) {
+      if (reader->SetEntry(seek_entry) != TTreeReader::kEntryValid) {
+        return nullptr;
+      }
+      ient = seek_entry;
+      seek_entry = -1;
+    } else if (!reader->Next()) {
       return nullptr;
     }
 
+    if (prefilter && !prefilter(header())) {
+      auto stub = MakePrefilteredStub(gri, ient++);
+      stub->weights()[0] = StubWeight() * FileWeightScale();
+      return stub;
+    }
+
     auto ge = ToGenEvent();
 
     ge->set_event_number(ient++);
     ge->set_run_info(gri);
     ge->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
-    // accounts for per-file variations over an input chain
-    ge->weights()[0] *=
-        *(*fScaleFactor) * double(reader->GetEntries()) * 1E38 / fatx;
+    ge->weights()[0] *= FileWeightScale();
 
     return ge;
   }
 
+  size_t first_table(ParticleTable &tbl, size_t n) {
+    tbl.clear();
+    if (!open()) {
+      return 0;
+    }
+
+    reader->Restart();
+    ient = 0;
+    seek_entry = -1;
+
+    return next_table(tbl, n);
+  }
+
+  size_t next_table(ParticleTable &tbl, size_t n) {
+    tbl.clear();
+    while (tbl.nevents() < n) {
+      if (seek_entry >= 0) {
+        if (reader->SetEntry(seek_entry) != TTreeReader::kEntryValid) {
+          break;
+        }
+        ient = seek_entry;
+        seek_entry = -1;
+      } else if (!reader->Next()) {
+        break;
+      }
+      FillTableEvent(tbl);
+      ient++;
+    }
+    return tbl.nevents();
+  }
+
+  std::shared_ptr<HepMC3::GenRunInfo> run_info() { return gri; }
+
+  // predicates see the FlatTree Mode, PDGnu and tgt branches
+  bool set_prefilter(EventHeaderFilterFunc filt) {
+    prefilter = filt;
+    return true;
+  }
+
+  bool seekable() { return true; }
+
+  size_t size() {
+    if (!reader) {
+      return 0;
+    }
+    return size_t(reader->GetEntries());
+  }
+
+  bool seek(size_t entry) {
+    if (!open()) {
+      return false;
+    }
+    if (Long64_t(entry) >= reader->GetEntries()) {
+      return false;
+    }
+    seek_entry = Long64_t(entry);
+    return true;
+  }
+
   static IEventSourcePtr MakeEventSource(YAML::Node const &cfg) {
     return std::make_shared<NUISANCE2FlatTreeEventSource>(cfg);
   }
+
+  static bool CanReadFile(std::filesystem::path const &filepath) {
+    return IsROOTFileWithTTree(filepath, "FlatTree_VARS");
+  }
 };
 
 IEventSourcePtr
@@ -564,9 +814,15 @@ NUISANCE2FlatTreeEventSource_MakeEventSource(YAML::Node const &cfg) {
   return NUISANCE2FlatTreeEventSource::MakeEventSource(cfg);
 }
 
+bool NUISANCE2FlatTreeEventSource_CanReadFile(
+    std::filesystem::path const &filepath) {
+  return NUISANCE2FlatTreeEventSource::CanReadFile(filepath);
+}
+
 #ifdef NUISANCE_USE_BOOSTDLL
 BOOST_DLL_ALIAS(nuis::NUISANCE2FlatTreeEventSource::MakeEventSource,
                 MakeEventSource);
+BOOST_DLL_ALIAS(nuis::NUISANCE2FlatTreeEventSource::CanReadFile, CanReadFile);
 #endif
 
 } // namespace nuis
\ No newline at end of file
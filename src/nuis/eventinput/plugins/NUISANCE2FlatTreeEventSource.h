@@ -2,9 +2,14 @@
 
 #include "nuis/eventinput/IEventSource.h"
 #include "yaml-cpp/yaml.h"
+
+#include <filesystem>
+
 namespace nuis {
 
 IEventSourcePtr
 NUISANCE2FlatTreeEventSource_MakeEventSource(YAML::Node const &cfg);
+bool NUISANCE2FlatTreeEventSource_CanReadFile(
+    std::filesystem::path const &filepath);
 
 } // namespace nuis
\ No newline at end of file
@@ -39,6 +39,7 @@ class NuWroevent1EventSource : public IEventSource {
 
 public:
   NuWroevent1EventSource(YAML::Node const &cfg) {
+    ConfigureROOTThreading(cfg);
     if (cfg["filepath"] &&
         HasTTree(cfg["filepath"].as<std::string>(), "treeout")) {
       filepaths.push_back(cfg["filepath"].as<std::string>());
@@ -51,10 +52,14 @@ public:
     }
   };
 
-  std::shared_ptr<HepMC3::GenEvent> first() {
+  // builds the chain and run info, only does work on the first call
+  bool open() {
+    if (chin) { // already opened
+      return ch_ents > 0;
+    }
 
     if (!filepaths.size()) {
-      return nullptr;
+      return false;
     }
 
     chin = std::make_unique<TChain>("treeout");
@@ -63,7 +68,7 @@ public:
       if (!chin->Add(ftr.c_str(), 0)) {
         log_warn("Could not find treeout in {}", ftr.native());
         chin.reset();
-        return nullptr;
+        return false;
       }
     }
 
@@ -71,7 +76,7 @@ public:
     ient = 0;
 
     if (ch_ents == 0) {
-      return nullptr;
+      return false;
     }
 
     ev = nullptr;
@@ -85,11 +90,16 @@ public:
     gri = nuwroconv::BuildRunInfo(ch_ents, fatx, ev->par);
 
     ch_fuid = chin->GetFile()->GetUUID();
-    ient = 0;
-    auto ge = nuwroconv::ToGenEvent(*ev, gri);
-    ge->set_event_number(ient);
-    ge->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
-    return ge;
+    return true;
+  }
+
+  std::shared_ptr<HepMC3::GenEvent> first() {
+    if (!open()) {
+      return nullptr;
+    }
+    // rewind, next() pre-increments
+    ient = -1;
+    return next();
   }
 
   std::shared_ptr<HepMC3::GenEvent> next() {
@@ -113,10 +123,35 @@ public:
     return ge;
   }
 
+  bool seekable() { return true; }
+
+  size_t size() {
+    if (!chin) {
+      return 0;
+    }
+    return size_t(ch_ents);
+  }
+
+  bool seek(size_t entry) {
+    if (!open()) {
+      return false;
+    }
+    if (Long64_t(entry) >= ch_ents) {
+      return false;
+    }
+    // next() pre-increments
+    ient = Long64_t(entry) - 1;
+    return true;
+  }
+
   static IEventSourcePtr MakeEventSource(YAML::Node const &cfg) {
     return std::make_shared<NuWroevent1EventSource>(cfg);
   }
 
+  static bool CanReadFile(std::filesystem::path const &filepath) {
+    return IsROOTFileWithTTree(filepath, "treeout");
+  }
+
   virtual ~NuWroevent1EventSource() {}
 };
 
@@ -124,8 +159,13 @@ IEventSourcePtr NuWroevent1EventSource_MakeEventSource(YAML::Node const &cfg) {
   return NuWroevent1EventSource::MakeEventSource(cfg);
 }
 
+bool NuWroevent1EventSource_CanReadFile(std::filesystem::path const &filepath) {
+  return NuWroevent1EventSource::CanReadFile(filepath);
+}
+
 #ifdef NUISANCE_USE_BOOSTDLL
 BOOST_DLL_ALIAS(nuis::NuWroevent1EventSource::MakeEventSource, MakeEventSource);
+BOOST_DLL_ALIAS(nuis::NuWroevent1EventSource::CanReadFile, CanReadFile);
 #endif
 
 } // namespace nuis
@@ -2,8 +2,12 @@
 
 #include "nuis/eventinput/IEventSource.h"
 #include "yaml-cpp/yaml.h"
+
+#include <filesystem>
+
 namespace nuis {
   
 IEventSourcePtr NuWroevent1EventSource_MakeEventSource(YAML::Node const &cfg);
+bool NuWroevent1EventSource_CanReadFile(std::filesystem::path const &filepath);
 
 } // namespace nuis
\ No newline at end of file
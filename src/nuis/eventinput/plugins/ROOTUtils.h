@@ -3,8 +3,11 @@
 #include "TDirectory.h"
 #include "TError.h"
 #include "TFile.h"
+#include "TROOT.h"
 #include "TTree.h"
 
+#include "yaml-cpp/yaml.h"
+
 #include <filesystem>
 #include <fstream>
 
@@ -20,6 +23,7 @@ inline bool IsROOTFile(std::filesystem::path filepath) {
   if (std::string(magicbytes) != "root") {
     return false;
   }
+  return true;
 }
 
 inline bool HasTTree(std::filesystem::path filepath,
@@ -51,4 +55,25 @@ inline bool HasTTree(std::filesystem::path filepath,
 
   auto tt = rsfg.f->Get<TTree>(treename.c_str());
   return bool(tt);
-}
\ No newline at end of file
+}
+
+// Cheap check used by the plugin CanReadFile probes. Local files are rejected
+// on their magic bytes before ROOT is asked to open them, remote paths are
+// passed straight to ROOT.
+inline bool IsROOTFileWithTTree(std::filesystem::path filepath,
+                                std::string const &treename) {
+  if (std::filesystem::exists(filepath) && !IsROOTFile(filepath)) {
+    return false;
+  }
+  return HasTTree(filepath, treename);
+}
+
+// Sources that will be driven from threads other than the one that
+// constructed them (see ReadAheadEventSource) are configured with thread_safe:
+// true by the EventSourceFactory. ROOT needs to know about this before any
+// concurrent I/O happens.
+inline void ConfigureROOTThreading(YAML::Node const &cfg) {
+  if (cfg["thread_safe"] && cfg["thread_safe"].as<bool>()) {
+    ROOT::EnableThreadSafety();
+  }
+}
@@ -11,6 +11,9 @@
 #include "TChain.h"
 #include "TFile.h"
 
+#include "NuHepMC/Constants.hxx"
+#include "NuHepMC/UnitsUtils.hxx"
+
 #include "HepMC3/GenRunInfo.h"
 
 #ifdef NUISANCE_USE_BOOSTDLL
@@ -24,6 +27,7 @@ namespace nuis {
 DECLARE_NUISANCE_EXCEPT(NeutVectNoFluxRateHistos);
 
 neutvectEventSource::neutvectEventSource(YAML::Node const &cfg) {
+  ConfigureROOTThreading(cfg);
   if (cfg["filepath"] &&
       HasTTree(cfg["filepath"].as<std::string>(), "neuttree")) {
     filepaths.push_back(cfg["filepath"].as<std::string>());
@@ -36,10 +40,13 @@ neutvectEventSource::neutvectEventSource(YAML::Node const &cfg) {
   }
 };
 
-std::shared_ptr<HepMC3::GenEvent> neutvectEventSource::first() {
+bool neutvectEventSource::open() {
+  if (chin) { // already opened
+    return ch_ents > 0;
+  }
 
   if (!filepaths.size()) {
-    return nullptr;
+    return false;
   }
 
   chin = std::make_unique<TChain>("neuttree");
@@ -48,7 +55,7 @@ std::shared_ptr<HepMC3::GenEvent> neutvectEventSource::first() {
     if (!chin->Add(ftr.c_str(), 0)) {
       log_warn("Could not find neuttree in {}", ftr.native());
       chin.reset();
-      return nullptr;
+      return false;
     }
   }
 
@@ -56,7 +63,7 @@ std::shared_ptr<HepMC3::GenEvent> neutvectEventSource::first() {
   ient = 0;
 
   if (ch_ents == 0) {
-    return nullptr;
+    return false;
   }
 
   nv = nullptr;
@@ -89,6 +96,7 @@ std::shared_ptr<HepMC3::GenEvent> neutvectEventSource::first() {
       flux_hist = std::move(frpair.second);
     } else {
       log_critical("Couldn't get nvconv::GetFluxRateHistPairFromChain");
+      chin.reset();
       throw NeutVectNoFluxRateHistos();
     }
   }
@@ -97,11 +105,16 @@ std::shared_ptr<HepMC3::GenEvent> neutvectEventSource::first() {
                              flux_energy_to_MeV);
 
   ch_fuid = chin->GetFile()->GetUUID();
-  ient = 0;
-  auto ge = nvconv::ToGenEvent(nv, gri);
-  ge->set_event_number(ient);
-  ge->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
-  return ge;
+  return true;
+}
+
+std::shared_ptr<HepMC3::GenEvent> neutvectEventSource::first() {
+  if (!open()) {
+    return nullptr;
+  }
+  // rewind, next() pre-increments
+  ient = -1;
+  return next();
 }
 
 std::shared_ptr<HepMC3::GenEvent> neutvectEventSource::next() {
@@ -117,12 +130,96 @@ std::shared_ptr<HepMC3::GenEvent> neutvectEventSource::next() {
     ch_fuid = chin->GetFile()->GetUUID();
   }
 
+  if (prefilter && !prefilter(header())) {
+    return MakePrefilteredStub(gri, ient);
+  }
+
   auto ge = nvconv::ToGenEvent(nv, gri);
   ge->set_event_number(ient);
   ge->set_units(HepMC3::Units::MEV, HepMC3::Units::CM);
   return ge;
 }
 
+EventHeader neutvectEventSource::header() {
+  EventHeader hdr{0, 0, 0, 0, 0};
+  hdr.native_mode = nv->Mode;
+  hdr.probe_pdg = nv->PartInfo(0)->fPID;
+  hdr.probe_energy = nv->PartInfo(0)->fP.E();
+  hdr.target_pdg =
+      NuHepMC::CrossSection::Units::NuclearPDG(nv->TargetZ, nv->TargetA);
+  return hdr;
+}
+
+void neutvectEventSource::fill_table_event(ParticleTable &tbl) {
+  auto hdr = header();
+  tbl.add_event(ient, hdr, 1);
+  // rejected entries keep their place in the table, but get no particles
+  if (prefilter && !prefilter(hdr)) {
+    return;
+  }
+
+  for (int i = 0; i < nv->Npart(); ++i) {
+    auto const &p = *nv->PartInfo(i);
+    int status = NuHepMC::ParticleStatus::DocumentationLine;
+    if (i == 0) {
+      status = NuHepMC::ParticleStatus::IncomingBeam;
+    } else if (i == 1) {
+      status = NuHepMC::ParticleStatus::StruckNucleon;
+    } else if (p.fIsAlive) {
+      status = NuHepMC::ParticleStatus::UndecayedPhysical;
+    }
+    tbl.add_particle(p.fPID, status, p.fP.Px(), p.fP.Py(), p.fP.Pz(),
+                     p.fP.E());
+    if (i == 1) {
+      tbl.add_particle(hdr.target_pdg, NuHepMC::ParticleStatus::Target, 0, 0,
+                       0, 0);
+    }
+  }
+}
+
+size_t neutvectEventSource::first_table(ParticleTable &tbl, size_t n) {
+  tbl.clear();
+  if (!open()) {
+    return 0;
+  }
+  // rewind, next_table() pre-increments
+  ient = -1;
+  return next_table(tbl, n);
+}
+
+size_t neutvectEventSource::next_table(ParticleTable &tbl, size_t n) {
+  tbl.clear();
+  while ((tbl.nevents() < n) && ((ient + 1) < ch_ents)) {
+    chin->GetEntry(++ient);
+    fill_table_event(tbl);
+  }
+  return tbl.nevents();
+}
+
+bool neutvectEventSource::set_prefilter(EventHeaderFilterFunc filt) {
+  prefilter = filt;
+  return true;
+}
+
+size_t neutvectEventSource::size() {
+  if (!chin) {
+    return 0;
+  }
+  return size_t(ch_ents);
+}
+
+bool neutvectEventSource::seek(size_t entry) {
+  if (!open()) {
+    return false;
+  }
+  if (Long64_t(entry) >= ch_ents) {
+    return false;
+  }
+  // next() pre-increments
+  ient = Long64_t(entry) - 1;
+  return true;
+}
+
 NeutVect *neutvectEventSource::neutvect(HepMC3::GenEvent const &ev) {
   chin->GetEntry(ev.event_number());
   return nv;
@@ -132,8 +229,13 @@ IEventSourcePtr neutvectEventSource::MakeEventSource(YAML::Node const &cfg) {
   return std::make_shared<neutvectEventSource>(cfg);
 }
 
+bool neutvectEventSource::CanReadFile(std::filesystem::path const &filepath) {
+  return IsROOTFileWithTTree(filepath, "neuttree");
+}
+
 #ifdef NUISANCE_USE_BOOSTDLL
 BOOST_DLL_ALIAS(nuis::neutvectEventSource::MakeEventSource, MakeEventSource);
+BOOST_DLL_ALIAS(nuis::neutvectEventSource::CanReadFile, CanReadFile);
 #endif
 
 } // namespace nuis
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "nuis/eventinput/IEventSource.h"
+#include "nuis/eventinput/ParticleTable.h"
 
 #include "TChain.h"
 
@@ -18,7 +19,8 @@ class NeutVect;
 
 namespace nuis {
 
-class neutvectEventSource : public IEventSource {
+class neutvectEventSource : public IEventSource,
+                            public IParticleTableSource {
 
   std::vector<std::filesystem::path> filepaths;
   std::unique_ptr<TChain> chin;
@@ -31,13 +33,36 @@ class neutvectEventSource : public IEventSource {
 
   NeutVect *nv;
 
+  EventHeaderFilterFunc prefilter;
+  EventHeader header();
+
+  void fill_table_event(ParticleTable &tbl);
+
+  // builds the chain and run info, only does work on the first call
+  bool open();
+
 public:
   neutvectEventSource(YAML::Node const &cfg);
 
   std::shared_ptr<HepMC3::GenEvent> first();
   std::shared_ptr<HepMC3::GenEvent> next();
 
+  // predicates see the NEUT mode, probe and target, process_id is left as 0
+  bool set_prefilter(EventHeaderFilterFunc filt);
+
+  // the table lists the NeutVect particle stack directly: the probe, the struck
+  // nucleon, the target nucleus and then the remaining particles, which are
+  // final state if they left the nucleus and documentation lines otherwise
+  size_t first_table(ParticleTable &tbl, size_t n);
+  size_t next_table(ParticleTable &tbl, size_t n);
+  std::shared_ptr<HepMC3::GenRunInfo> run_info() { return gri; }
+
+  bool seekable() { return true; }
+  size_t size();
+  bool seek(size_t entry);
+
   static IEventSourcePtr MakeEventSource(YAML::Node const &cfg);
+  static bool CanReadFile(std::filesystem::path const &filepath);
 
   NeutVect *neutvect(HepMC3::GenEvent const &);
 
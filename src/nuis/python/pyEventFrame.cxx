@@ -7,6 +7,7 @@
 #include "arrow/python/pyarrow.h"
 #endif
 
+#include "nuis/eventframe/FrameExpression.h"
 #include "nuis/eventframe/utility.h"
 
 #include "ProSelecta/env.h"
@@ -21,11 +22,21 @@ pyEventFrameGen::pyEventFrameGen(pyNormalizedEventSource ev, size_t bsize) {
   gen = std::make_shared<EventFrameGen>(ev.evs, bsize);
 }
 
+pyEventFrameGen::pyEventFrameGen(YAML::Node const &cfg, size_t nshards,
+                                 size_t bsize) {
+  gen = std::make_shared<EventFrameGen>(cfg, nshards, bsize);
+}
+
 pyEventFrameGen pyEventFrameGen::filter(EventFrameGen::FilterFunc filt) {
   *gen = gen->filter(filt);
   return *this;
 }
 
+pyEventFrameGen pyEventFrameGen::prefilter(EventHeaderFilterFunc filt) {
+  *gen = gen->prefilter(filt);
+  return *this;
+}
+
 pyEventFrameGen
 pyEventFrameGen::add_bool_columns(std::vector<std::string> const &col_names,
                                   EventFrameGen::ProjectionsFunc<bool> proj) {
@@ -133,13 +144,34 @@ pyEventFrameGen pyEventFrameGen::progress(size_t nmax) {
   return *this;
 }
 
+pyEventFrameGen pyEventFrameGen::threads(size_t n) {
+  *gen = gen->threads(n);
+  return *this;
+}
+
+// the GIL is released so that, with threads(n) or a sharded all(), python
+// filters and projections can be called from the worker threads, which would
+// otherwise deadlock against the joining thread
 nuis::EventFrame pyEventFrameGen::first(size_t nchunk) {
+  py::gil_scoped_release nogil;
   return gen->first(nchunk);
 }
 nuis::EventFrame pyEventFrameGen::next(size_t nchunk) {
+  py::gil_scoped_release nogil;
   return gen->next(nchunk);
 }
-nuis::EventFrame pyEventFrameGen::all() { return gen->all(); }
+nuis::EventFrame pyEventFrameGen::all() {
+  py::gil_scoped_release nogil;
+  return gen->all();
+}
+
+nuis::TypedEventFrame pyEventFrameGen::firstTyped(size_t nchunk) {
+  return gen->firstTyped(nchunk);
+}
+nuis::TypedEventFrame pyEventFrameGen::nextTyped(size_t nchunk) {
+  return gen->nextTyped(nchunk);
+}
+nuis::TypedEventFrame pyEventFrameGen::allTyped() { return gen->allTyped(); }
 
 #ifdef NUIS_ARROW_ENABLED
 pybind11::object pyEventFrameGen::firstArrow(size_t nchunk) {
@@ -189,6 +221,27 @@ void frame_settattr(EventFrame &s, std::string const &column,
   }
 }
 
+// returns a copy of the column as a numpy array of the column's type
+py::object typed_frame_gettattr(TypedEventFrame const &s,
+                                std::string const &column) {
+  auto cid = s.require_column_index(column);
+  switch (s.column_typenums[cid]) {
+#define X(t)                                                                   \
+  case column_type<t>::id:                                                     \
+    return py::cast(s.col<t>(cid));
+
+    X(bool)
+    X(int)
+    X(uint)
+    X(int16_t)
+    X(uint16_t)
+    X(float)
+    X(double)
+#undef X
+  }
+  return py::none();
+}
+
 void pyEventFrameInit(py::module &m) {
 
 #ifdef NUIS_ARROW_ENABLED
@@ -214,6 +267,18 @@ void pyEventFrameInit(py::module &m) {
       .def("__getitem__", &frame_gettattr)
       .def("__setitem__", &frame_settattr)
       .def("__str__", &str_via_ss<EventFrame>)
+      .def(
+          "derive",
+          [](EventFrame &s, std::string const &name, std::string const &expr) {
+            DeriveColumn(s, name, expr);
+          },
+          py::arg("name"), py::arg("expression"))
+      .def(
+          "derive",
+          [](EventFrame &s,
+             std::vector<std::pair<std::string, std::string>> const
+                 &name_exprs) { DeriveColumns(s, name_exprs); },
+          py::arg("name_expressions"))
       .def_static(
           "get_best_fatx_per_sumw_estimate",
           [](EventFrame const &ef,
@@ -245,10 +310,27 @@ void pyEventFrameInit(py::module &m) {
 #endif
       ;
 
+  py::class_<TypedEventFrame>(m, "TypedEventFrame")
+      .def(py::init<>())
+      .def_readonly("column_names", &TypedEventFrame::column_names)
+      .def_readonly("num_rows", &TypedEventFrame::num_rows)
+      .def("__bool__",
+           [](TypedEventFrame const &s) { return bool(s.num_rows); })
+      .def("find_column_index", &TypedEventFrame::find_column_index)
+      .def("topRows", &TypedEventFrame::topRows)
+      .def("as_EventFrame", &TypedEventFrame::as_EventFrame)
+      .def("data_size", &TypedEventFrame::data_size)
+      .def("__getattr__", &typed_frame_gettattr)
+      .def("__getitem__", &typed_frame_gettattr)
+      .def("__str__", &str_via_ss<TypedEventFrame>);
+
   py::class_<pyEventFrameGen>(m, "EventFrameGen")
       .def(py::init<pyNormalizedEventSource, size_t>(), py::arg("event_source"),
            py::arg("block_size") = 250000)
+      .def(py::init<YAML::Node const &, size_t, size_t>(), py::arg("config"),
+           py::arg("nshards"), py::arg("block_size") = 250000)
       .def("filter", &pyEventFrameGen::filter)
+      .def("prefilter", &pyEventFrameGen::prefilter)
 #ifdef NUIS_ARROW_ENABLED
       .def_static("has_arrow_support", []() { return true; })
 #else
@@ -273,6 +355,7 @@ void pyEventFrameInit(py::module &m) {
       .def("limit", &pyEventFrameGen::limit)
       .def("limit", [](pyEventFrameGen &s, double i) { return s.limit(i); })
       .def("progress", &pyEventFrameGen::progress, py::arg("every") = 100000)
+      .def("threads", &pyEventFrameGen::threads, py::arg("n"))
       .def("first", &pyEventFrameGen::first,
            py::arg("nchunk") = std::numeric_limits<size_t>::max())
       .def("next", &pyEventFrameGen::next,
@@ -283,5 +366,10 @@ void pyEventFrameInit(py::module &m) {
       .def("nextArrow", &pyEventFrameGen::nextArrow,
            py::arg("nchunk") = std::numeric_limits<size_t>::max())
 #endif
-      .def("all", &pyEventFrameGen::all);
+      .def("all", &pyEventFrameGen::all)
+      .def("firstTyped", &pyEventFrameGen::firstTyped,
+           py::arg("nchunk") = std::numeric_limits<size_t>::max())
+      .def("nextTyped", &pyEventFrameGen::nextTyped,
+           py::arg("nchunk") = std::numeric_limits<size_t>::max())
+      .def("allTyped", &pyEventFrameGen::allTyped);
 }
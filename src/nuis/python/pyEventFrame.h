@@ -12,8 +12,10 @@
 
 struct pyEventFrameGen {
   pyEventFrameGen(pyNormalizedEventSource ev, size_t bsize);
+  pyEventFrameGen(YAML::Node const &cfg, size_t nshards, size_t bsize);
 
   pyEventFrameGen filter(nuis::EventFrameGen::FilterFunc filt);
+  pyEventFrameGen prefilter(nuis::EventHeaderFilterFunc filt);
 
   pyEventFrameGen
   add_bool_columns(std::vector<std::string> const &col_names,
@@ -69,10 +71,16 @@ struct pyEventFrameGen {
 
   pyEventFrameGen progress(size_t nmax);
 
+  pyEventFrameGen threads(size_t n);
+
   nuis::EventFrame first(size_t nchunk);
   nuis::EventFrame next(size_t nchunk);
   nuis::EventFrame all();
 
+  nuis::TypedEventFrame firstTyped(size_t nchunk);
+  nuis::TypedEventFrame nextTyped(size_t nchunk);
+  nuis::TypedEventFrame allTyped();
+
 #ifdef NUIS_ARROW_ENABLED
   pybind11::object firstArrow(size_t nchunk);
   pybind11::object nextArrow(size_t nchunk);
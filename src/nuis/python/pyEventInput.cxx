@@ -1,9 +1,14 @@
 #include "nuis/python/pyEventInput.h"
 
 #include "nuis/eventinput/CombinedNormalizedEventSource.h"
+#include "nuis/eventinput/EventIndex.h"
+#include "nuis/eventinput/Skim.h"
+#include "nuis/eventinput/UnweightedNormalizedEventSource.h"
 
 #include "NuHepMC/UnitsUtils.hxx"
 
+#include "pybind11/functional.h"
+
 namespace py = pybind11;
 using namespace nuis;
 
@@ -48,6 +53,19 @@ py::object pyNormalizedEventSource::next() {
   return curr_event;
 }
 
+py::list pyNormalizedEventSource::next_batch(size_t n) {
+  py::list evts;
+  if (!evs) {
+    return evts;
+  }
+  evs->next_batch(batch, n);
+  for (auto &[evt, cv_weight] : batch) {
+    evts.append(py::make_tuple(evt, cv_weight));
+  }
+  batch.clear();
+  return evts;
+}
+
 std::shared_ptr<HepMC3::GenRunInfo> pyNormalizedEventSource::run_info() {
   return gri;
 }
@@ -161,31 +179,67 @@ void pyEventInputInit(py::module &m) {
       .def_readonly("nevents", &NormInfo::nevents)
       .def("fatx_per_sumweights", &NormInfo::fatx_per_sumweights);
 
+  py::class_<EventHeader>(m, "EventHeader")
+      .def_readonly("process_id", &EventHeader::process_id)
+      .def_readonly("native_mode", &EventHeader::native_mode)
+      .def_readonly("probe_pdg", &EventHeader::probe_pdg)
+      .def_readonly("probe_energy", &EventHeader::probe_energy)
+      .def_readonly("target_pdg", &EventHeader::target_pdg);
+
   py::class_<pyNormalizedEventSource>(m, "EventSource")
       .def(py::init<std::string const &>())
       .def(py::init<YAML::Node const &>())
       .def_static(
           "Summed",
-          [](std::vector<pyNormalizedEventSource> pycomponents) {
+          [](std::vector<pyNormalizedEventSource> pycomponents,
+             size_t read_ahead) {
             std::vector<NormalizedEventSourcePtr> components;
             for (auto &c : pycomponents) {
               components.push_back(c.evs);
             }
             return pyNormalizedEventSource(
-                CombinedNormalizedEventSource::SumEventSources(components));
-          })
+                CombinedNormalizedEventSource::SumEventSources(components,
+                                                               read_ahead));
+          },
+          py::arg("components"), py::arg("read_ahead") = 0)
       .def_static(
           "Averaged",
-          [](std::vector<pyNormalizedEventSource> pycomponents) {
+          [](std::vector<pyNormalizedEventSource> pycomponents,
+             size_t read_ahead) {
             std::vector<NormalizedEventSourcePtr> components;
             for (auto &c : pycomponents) {
               components.push_back(c.evs);
             }
             return pyNormalizedEventSource(
-                CombinedNormalizedEventSource::AverageEventSources(components));
-          })
+                CombinedNormalizedEventSource::AverageEventSources(
+                    components, read_ahead));
+          },
+          py::arg("components"), py::arg("read_ahead") = 0)
+      .def_static(
+          "Unweighted",
+          [](pyNormalizedEventSource weighted, double max_weight,
+             uint64_t seed) {
+            return pyNormalizedEventSource(
+                std::make_shared<UnweightedNormalizedEventSource>(
+                    weighted.evs, max_weight, seed));
+          },
+          py::arg("source"), py::arg("max_weight"), py::arg("seed") = 0)
+      .def_static(
+          "Indexed",
+          [](YAML::Node const &node, std::string const &selection_name,
+             std::function<int(HepMC3::GenEvent const &)> const &selection,
+             bool store_weights) {
+            return pyNormalizedEventSource(
+                EventSourceFactory()
+                    .make_indexed(node, selection_name, selection,
+                                  store_weights)
+                    .second);
+          },
+          py::arg("config"), py::arg("selection_name"), py::arg("selection"),
+          py::arg("store_weights") = true)
       .def("first", &pyNormalizedEventSource::first)
       .def("next", &pyNormalizedEventSource::next)
+      .def("next_batch", &pyNormalizedEventSource::next_batch, py::arg("n"))
       .def("run_info", &pyNormalizedEventSource::run_info)
       .def("norm_info", &pyNormalizedEventSource::norm_info,
            py::arg("units") = NuHepMC::CrossSection::Units::cm2ten38_PerNucleon)
@@ -216,4 +270,17 @@ void pyEventInputInit(py::module &m) {
           "__iter__",
           [](pyEventSource &s) { return py::make_iterator(begin(s), end(s)); },
           py::keep_alive<0, 1>());
+
+  py::class_<SkimSummary>(m, "SkimSummary")
+      .def_readonly("parent", &SkimSummary::parent)
+      .def_readonly("nselected", &SkimSummary::nselected);
+
+  m.def(
+      "skim",
+      [](pyNormalizedEventSource &source,
+         std::function<int(HepMC3::GenEvent const &)> const &selection,
+         std::string const &output) {
+        return Skim(source.evs, selection, output);
+      },
+      py::arg("source"), py::arg("selection"), py::arg("output"));
 }
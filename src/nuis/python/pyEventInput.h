@@ -9,6 +9,7 @@ struct pyNormalizedEventSource {
   std::shared_ptr<HepMC3::GenRunInfo> gri;
   nuis::NormalizedEventSourcePtr evs;
   pybind11::tuple curr_event;
+  std::vector<nuis::EventCVWeightPair> batch;
 
   pyNormalizedEventSource(nuis::NormalizedEventSourcePtr);
   pyNormalizedEventSource(std::string const &filename);
@@ -16,6 +17,7 @@ struct pyNormalizedEventSource {
 
   pybind11::object first();
   pybind11::object next();
+  pybind11::list next_batch(size_t n);
   std::shared_ptr<HepMC3::GenRunInfo> run_info();
   nuis::NormInfo
   norm_info(NuHepMC::CrossSection::Units::Unit const &units) const;
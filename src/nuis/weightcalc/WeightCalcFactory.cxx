@@ -1,3 +1,4 @@
+#include "nuis/eventinput/CachingEventSource.h"
 #include "nuis/eventinput/IEventSourceWrapper.h"
 
 #include "nuis/weightcalc/WeightCalcFactory.h"
@@ -12,13 +13,40 @@
 #include "nuis/weightcalc/plugins/plugins.h"
 #endif
 
+#include "HepMC3/Attribute.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenRunInfo.h"
+
 #include <regex>
 
 DECLARE_NUISANCE_EXCEPT(NUISANCE_ROOTUndefined);
 DECLARE_NUISANCE_EXCEPT(UnableToProvisionWeightCalcPlugin);
 DECLARE_NUISANCE_EXCEPT(InvalidWeightCalcPluginRequested);
+DECLARE_NUISANCE_EXCEPT(WeightCalcOnEventCache);
 
 namespace nuis {
+
+namespace {
+// event caches only hold the HepMC3 events, so weight calcs that need the
+// generator's own event records cannot process them
+void CheckNotEventCache(IEventSourcePtr evs) {
+  auto ev = evs->first();
+  if (!ev || !ev->run_info()) {
+    return;
+  }
+  auto plugin = ev->run_info()->attribute<HepMC3::StringAttribute>(
+      EventCachePluginAttribute);
+  if (plugin) {
+    throw WeightCalcOnEventCache()
+        << "No weight calc can process the proffered IEventSource, which "
+           "reads an event cache written from the "
+        << plugin->value()
+        << " EventInput plugin. Event caches do not hold the generator's "
+           "own event records, set cache: false on inputs to reweight.";
+  }
+}
+} // namespace
+
 WeightCalcFactory::WeightCalcFactory() {
 
 #ifdef NUISANCE_USE_BOOSTDLL
@@ -117,6 +145,7 @@ IWeightCalcHM3MapPtr WeightCalcFactory::make(IEventSourcePtr evs,
         if (wc->good()) {
           return wc;
         } else {
+          CheckNotEventCache(evs);
           log_critical(
               "Explicitly asked for weightcalc plugin: {}, but it failed to "
               "configure itself with the proferred event source.");
@@ -141,9 +170,14 @@ IWeightCalcHM3MapPtr WeightCalcFactory::make(IEventSourcePtr evs,
     }
   }
 
+  CheckNotEventCache(evs);
   return nullptr;
 #else
-  return TryAllKnownWeightPlugins(evs, cfg);
+  IWeightCalcHM3MapPtr wc = TryAllKnownWeightPlugins(evs, cfg);
+  if (!wc) {
+    CheckNotEventCache(evs);
+  }
+  return wc;
 #endif
 }
 
@@ -63,6 +63,7 @@ GENIEReWeightCalc::GENIEReWeightCalc(IEventSourcePtr evs,
              "GHEP3EventSource.");
     return;
   }
+  nevs->LoadSplines();
   fGENIE3RW = std::make_unique<genie::rew::GReWeight>();
 
   auto adopt_engines = cfg["adopt"]
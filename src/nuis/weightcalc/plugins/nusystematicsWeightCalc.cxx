@@ -101,6 +101,7 @@ nusystematicsWeightCalc::nusystematicsWeightCalc(IEventSourcePtr evs,
         "GHEP3EventSource.");
     return;
   }
+  nevs->LoadSplines();
   if (!cfg["param_headers"]) {
     throw NoParamHeaders()
         << "nusystematicsWeightCalc: On initialisation, no param_headers key "
@@ -2,6 +2,8 @@
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 
 #include "nuis/eventframe/EventFrame.h"
+#include "nuis/eventframe/FrameExpression.h"
+#include "nuis/eventframe/TypedEventFrame.h"
 
 #include <cassert>
 
@@ -72,3 +74,207 @@ TEST_CASE("Set Eigen::Ref from EventFrame::cols(strings)", "[EventFrame]") {
   REQUIRE(f.cols({"b"})[0][1] == -123);
   REQUIRE(f.cols({"c"})[0][1] == -123);
 }
+
+TEST_CASE("TypedEventFrame::col<T>(string)", "[TypedEventFrame]") {
+  nuis::TypedEventFrame f;
+  f.num_rows = 3;
+  f.add_column<bool>("a") << true, false, true;
+  f.add_column<int>("b") << 1, 2, 3;
+  f.add_column<double>("c") << 1.5, 2.5, 3.5;
+
+  REQUIRE(f.find_column_index("a") == 0);
+  REQUIRE(f.find_column_index("c") == 2);
+  REQUIRE(f.find_column_index("d") == nuis::TypedEventFrame::npos);
+
+  REQUIRE(f.col<bool>("a")[1] == false);
+  REQUIRE(f.col<int>("b")[2] == 3);
+  REQUIRE(f.col<double>("c")[0] == 1.5);
+
+  REQUIRE_THROWS_AS(f.col<double>("a"), nuis::InvalidFrameColumnType);
+  REQUIRE_THROWS_AS(f.col<int>("d"), nuis::InvalidFrameColumnName);
+
+  f.col<int>("b")[0] = -123;
+  REQUIRE(f.col<int>("b")[0] == -123);
+}
+
+TEST_CASE("TypedEventFrame double view", "[TypedEventFrame]") {
+  nuis::TypedEventFrame f;
+  f.num_rows = 2;
+  f.add_column<bool>("a") << true, false;
+  f.add_column<uint16_t>("b") << 7, 8;
+  f.add_column<float>("c") << 0.5, 0.25;
+
+  auto ef = f.as_EventFrame();
+  REQUIRE(ef.num_rows == 2);
+  REQUIRE(ef.column_names == f.column_names);
+  REQUIRE(ef.col("a")[0] == 1);
+  REQUIRE(ef.col("a")[1] == 0);
+  REQUIRE(ef.col("b")[1] == 8);
+  REQUIRE(ef.col("c")[0] == 0.5);
+  REQUIRE(f.col_as_double("c")[1] == 0.25);
+
+  REQUIRE(f.data_size() ==
+          2 * (sizeof(bool) + sizeof(uint16_t) + sizeof(float)));
+}
+
+TEST_CASE("TypedEventFrame::Concatenate", "[TypedEventFrame]") {
+  std::vector<nuis::TypedEventFrame> frames(3);
+  for (int i = 0; i < 3; ++i) {
+    frames[i].num_rows = i + 1;
+    frames[i].add_column<int>("a") =
+        Eigen::ArrayXi::Constant(frames[i].num_rows, i);
+    frames[i].add_column<double>("b") =
+        Eigen::ArrayXd::Constant(frames[i].num_rows, 10 * i);
+  }
+
+  auto f = nuis::TypedEventFrame::Concatenate(frames);
+  REQUIRE(f.num_rows == 6);
+  REQUIRE(f.col<int>("a")[0] == 0);
+  REQUIRE(f.col<int>("a")[2] == 1);
+  REQUIRE(f.col<int>("a")[5] == 2);
+  REQUIRE(f.col<double>("b")[3] == 20);
+
+  auto top = f.topRows(2);
+  REQUIRE(top.num_rows == 2);
+  REQUIRE(top.col<int>("a").size() == 2);
+  REQUIRE(top.col<int>("a")[1] == 1);
+  REQUIRE(top.col<double>("b").size() == 2);
+  REQUIRE(top.col<double>("b")[1] == 10);
+}
+
+TEST_CASE("EventFrame::Concatenate", "[EventFrame]") {
+  std::vector<nuis::EventFrame> frames(3);
+  for (int i = 0; i < 3; ++i) {
+    frames[i].column_names = {"a", "b"};
+    frames[i].table = Eigen::ArrayXXd::Constant(i + 1, 2, i);
+    frames[i].num_rows = i + 1;
+  }
+
+  auto f = nuis::EventFrame::Concatenate(frames);
+  REQUIRE(f.num_rows == 6);
+  REQUIRE(f.table.rows() == 6);
+  REQUIRE(f.col("a")[0] == 0);
+  REQUIRE(f.col("b")[2] == 1);
+  REQUIRE(f.col("a")[5] == 2);
+
+  frames[1].column_names = {"a", "c"};
+  REQUIRE_THROWS_AS(nuis::EventFrame::Concatenate(frames),
+                    nuis::InvalidFrameColumnName);
+}
+
+TEST_CASE("FrameExpression arithmetic", "[FrameExpression]") {
+  nuis::EventFrame f;
+  f.column_names = {"enu", "emu", "event.number"};
+  f.table = Eigen::ArrayXXd(3, 3);
+  f.table.col(0) << 10, 20, 30;
+  f.table.col(1) << 1, 2, 3;
+  f.table.col(2) << 0, 1, 2;
+  f.num_rows = 3;
+
+  auto q0 = nuis::FrameExpression("enu - emu").evaluate(f);
+  REQUIRE(q0[0] == 9);
+  REQUIRE(q0[2] == 27);
+
+  auto prec = nuis::FrameExpression("-2 * (enu + 1) / 2 + emu").evaluate(f);
+  REQUIRE(prec[1] == -19);
+
+  auto fn = nuis::FrameExpression("sqrt(pow(emu, 2)) + max(emu, 2.5)")
+                .evaluate(f);
+  REQUIRE(fn[0] == 3.5);
+  REQUIRE(fn[2] == 6);
+
+  auto dotted = nuis::FrameExpression("`event.number` + event.number")
+                    .evaluate(f);
+  REQUIRE(dotted[2] == 4);
+}
+
+TEST_CASE("FrameExpression boolean", "[FrameExpression]") {
+  nuis::EventFrame f;
+  f.column_names = {"nmu", "npi"};
+  f.table = Eigen::ArrayXXd(4, 2);
+  f.table.col(0) << 1, 1, 0, 2;
+  f.table.col(1) << 0, 1, 0, 0;
+  f.num_rows = 4;
+
+  auto sel = nuis::FrameExpression("(nmu == 1) & (npi == 0)").evaluate(f);
+  REQUIRE(sel[0] == 1);
+  REQUIRE(sel[1] == 0);
+  REQUIRE(sel[2] == 0);
+  REQUIRE(sel[3] == 0);
+
+  auto any = nuis::FrameExpression("!(nmu > 1 || npi >= 1)").evaluate(f);
+  REQUIRE(any[0] == 1);
+  REQUIRE(any[1] == 0);
+  REQUIRE(any[3] == 0);
+
+  auto wh = nuis::FrameExpression("where(npi, -1, nmu)").evaluate(f);
+  REQUIRE(wh[1] == -1);
+  REQUIRE(wh[3] == 2);
+}
+
+TEST_CASE("FrameExpression errors and missing data", "[FrameExpression]") {
+  REQUIRE_THROWS_AS(nuis::FrameExpression("a +"),
+                    nuis::InvalidFrameExpression);
+  REQUIRE_THROWS_AS(nuis::FrameExpression("(a"), nuis::InvalidFrameExpression);
+  REQUIRE_THROWS_AS(nuis::FrameExpression("foo(a)"),
+                    nuis::InvalidFrameExpression);
+  REQUIRE_THROWS_AS(nuis::FrameExpression("pow(a)"),
+                    nuis::InvalidFrameExpression);
+  REQUIRE_THROWS_AS(nuis::FrameExpression("a $ b"),
+                    nuis::InvalidFrameExpression);
+
+  nuis::EventFrame f;
+  f.column_names = {"a", "b"};
+  f.table = Eigen::ArrayXXd(2, 2);
+  f.table.col(0) << 1, nuis::kMissingDatum<double>;
+  f.table.col(1) << 2, 3;
+  f.num_rows = 2;
+
+  REQUIRE_THROWS_AS(nuis::FrameExpression("c").evaluate(f),
+                    nuis::InvalidFrameColumnName);
+
+  auto sum = nuis::FrameExpression("a + b").evaluate(f);
+  REQUIRE(sum[0] == 3);
+  REQUIRE(sum[1] == nuis::kMissingDatum<double>);
+}
+
+TEST_CASE("FrameExpression over several blocks", "[FrameExpression]") {
+  nuis::EventFrame f;
+  f.column_names = {"a", "b"};
+  f.table = Eigen::ArrayXXd(10000, 2);
+  f.table.col(0) = Eigen::ArrayXd::LinSpaced(10000, 0, 9999);
+  f.table.col(1) = 2;
+  f.table(5000, 1) = nuis::kMissingDatum<double>;
+  f.num_rows = 10000;
+
+  auto res = nuis::FrameExpression("where(a > 4999, a * b, -a) + 1")
+                 .evaluate(f);
+  REQUIRE(res.size() == 10000);
+  REQUIRE(res[0] == 1);
+  REQUIRE(res[4999] == -4998);
+  REQUIRE(res[5000] == nuis::kMissingDatum<double>);
+  REQUIRE(res[5001] == 10003);
+  REQUIRE(res[9999] == 19999);
+}
+
+TEST_CASE("DeriveColumns", "[FrameExpression]") {
+  nuis::EventFrame f;
+  f.column_names = {"px", "pz"};
+  f.table = Eigen::ArrayXXd(2, 2);
+  f.table.col(0) << 3, 0;
+  f.table.col(1) << 4, 2;
+  f.num_rows = 2;
+
+  nuis::DeriveColumns(f, {{"p", "sqrt(px*px + pz*pz)"}, {"cos", "pz/p"}});
+  REQUIRE(f.column_names.size() == 4);
+  REQUIRE(f.table.cols() == 4);
+  REQUIRE(f.col("p")[0] == 5);
+  REQUIRE_THAT(f.col("cos")[0], Catch::Matchers::WithinAbs(0.8, 1E-12));
+  REQUIRE(f.col("cos")[1] == 1);
+
+  REQUIRE_THROWS_AS(nuis::DeriveColumn(f, "p", "px"),
+                    nuis::InvalidFrameColumnName);
+  REQUIRE_THROWS_AS(nuis::DeriveColumns(f, {{"q", "px"}, {"r", "s"}}),
+                    nuis::InvalidFrameColumnName);
+  REQUIRE(f.table.cols() == 4);
+}
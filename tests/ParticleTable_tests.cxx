@@ -0,0 +1,75 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+#include "nuis/eventinput/EventSourceFactory.h"
+#include "nuis/eventinput/IEventSourceWrapper.h"
+#include "nuis/eventinput/ParticleTable.h"
+
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <tuple>
+#include <vector>
+
+using ParticleSummary = std::tuple<int, int, double>;
+
+// Compares the particles of the first 1000 events of the GHEP3 file given by
+// NUISANCE_TEST_GHEP3_FILE, the test does nothing if it is not set
+TEST_CASE("GHEP3 ParticleTable matches ToGenEvent", "[ParticleTable]") {
+  auto ghep3_file = std::getenv("NUISANCE_TEST_GHEP3_FILE");
+  if (!ghep3_file) {
+    WARN("NUISANCE_TEST_GHEP3_FILE is not set, skipping.");
+    return;
+  }
+
+  YAML::Node cfg;
+  cfg["filepath"] = ghep3_file;
+  cfg["plugin_name"] = "GHEP3";
+
+  auto [gri, evs] =
+      nuis::EventSourceFactory().make_unnormalized(YAML::Clone(cfg));
+  REQUIRE(evs);
+  auto [tgri, tevs] =
+      nuis::EventSourceFactory().make_unnormalized(YAML::Clone(cfg));
+  REQUIRE(tevs);
+
+  auto tbls = std::dynamic_pointer_cast<nuis::IParticleTableSource>(tevs);
+  if (auto wrapper = std::dynamic_pointer_cast<nuis::IEventSourceWrapper>(tevs);
+      !tbls && wrapper) {
+    tbls = std::dynamic_pointer_cast<nuis::IParticleTableSource>(
+        wrapper->unwrap());
+  }
+  REQUIRE(tbls);
+
+  nuis::ParticleTable tbl;
+  REQUIRE(tbls->first_table(tbl, 1000));
+
+  size_t ev_it = 0;
+  for (auto ev = evs->first(); ev && (ev_it < tbl.nevents());
+       ev = evs->next(), ++ev_it) {
+    REQUIRE(tbl.event_number[ev_it] == ev->event_number());
+
+    std::vector<ParticleSummary> ev_parts, tbl_parts;
+    for (auto const &p : ev->particles()) {
+      ev_parts.emplace_back(p->pid(), p->status(), p->momentum().e());
+    }
+    for (size_t i = tbl.begin_particle(ev_it); i < tbl.end_particle(ev_it);
+         ++i) {
+      tbl_parts.emplace_back(tbl.pdg[i], tbl.status[i], tbl.E[i]);
+    }
+    std::sort(ev_parts.begin(), ev_parts.end());
+    std::sort(tbl_parts.begin(), tbl_parts.end());
+
+    REQUIRE(ev_parts.size() == tbl_parts.size());
+    for (size_t i = 0; i < ev_parts.size(); ++i) {
+      REQUIRE(std::get<0>(ev_parts[i]) == std::get<0>(tbl_parts[i]));
+      REQUIRE(std::get<1>(ev_parts[i]) == std::get<1>(tbl_parts[i]));
+      REQUIRE_THAT(std::get<2>(ev_parts[i]),
+                   Catch::Matchers::WithinRel(std::get<2>(tbl_parts[i]),
+                                              1E-8));
+    }
+  }
+  REQUIRE(ev_it == tbl.nevents());
+}